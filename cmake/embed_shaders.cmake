@@ -0,0 +1,68 @@
+# Generates a C++ source embedding SPIR-V binaries as uint32_t arrays.
+#
+# Usage:
+#   cmake -DOUTPUT=<file.cpp> -DSHADERS=<a.spv|b.spv|...> -P embed_shaders.cmake
+#
+# Each shader is registered under its file name without the .spv suffix, e.g.
+# histogram.comp.spv becomes "histogram.comp"; see mynydd/embedded_shaders.hpp.
+
+if(NOT DEFINED OUTPUT OR NOT DEFINED SHADERS)
+    message(FATAL_ERROR "embed_shaders.cmake requires OUTPUT and SHADERS")
+endif()
+
+string(REPLACE "|" ";" SHADER_LIST "${SHADERS}")
+
+set(ARRAYS "")
+set(TABLE "")
+set(INDEX 0)
+foreach(SHADER ${SHADER_LIST})
+    get_filename_component(FILE_NAME ${SHADER} NAME)
+    string(REGEX REPLACE "\\.spv$" "" SHADER_NAME ${FILE_NAME})
+
+    file(READ ${SHADER} HEX_CONTENT HEX)
+    string(LENGTH "${HEX_CONTENT}" HEX_LENGTH)
+    math(EXPR REMAINDER "${HEX_LENGTH} % 8")
+    if(NOT REMAINDER EQUAL 0)
+        message(FATAL_ERROR "${SHADER} is not a whole number of 32-bit words")
+    endif()
+    math(EXPR WORD_COUNT "${HEX_LENGTH} / 8")
+
+    # SPIR-V words are stored little-endian
+    string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u," WORDS "${HEX_CONTENT}")
+    # Break into lines of eight words
+    string(REPEAT "0x[0-9a-f]+u," 8 EIGHT_WORDS)
+    string(REGEX REPLACE "(${EIGHT_WORDS})" "\\1\n        " WORDS "${WORDS}")
+    string(REGEX REPLACE "\n        $" "" WORDS "${WORDS}")
+
+    string(APPEND ARRAYS "    const uint32_t shader${INDEX}[] = {\n        ${WORDS}\n    };\n\n")
+    string(APPEND TABLE "    {\"${SHADER_NAME}\", shader${INDEX}, ${WORD_COUNT}},\n")
+    math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+set(CONTENT "// Generated by cmake/embed_shaders.cmake. Do not edit.
+#include <cstddef>
+#include <cstdint>
+
+#include <mynydd/embedded_shaders.hpp>
+
+namespace mynydd {
+namespace {
+
+${ARRAYS}}
+
+const EmbeddedShader embeddedShaders[] = {
+${TABLE}};
+
+const size_t embeddedShaderCount = ${INDEX};
+
+}
+")
+
+# Only touch the output when it changes, to avoid needless rebuilds
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} OLD_CONTENT)
+    if(OLD_CONTENT STREQUAL CONTENT)
+        return()
+    endif()
+endif()
+file(WRITE ${OUTPUT} "${CONTENT}")
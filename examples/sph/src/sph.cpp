@@ -5,6 +5,7 @@
 #include <random>
 #include <glm/glm.hpp>
 #include <mynydd/mynydd.hpp>
+#include <mynydd/pipeline_builder.hpp>
 #include <mynydd/pipelines/particle_index.hpp>
 #include <sstream>
 #include <string>
@@ -242,6 +243,9 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
     auto inputDensities = inputData.densities;
 
     auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    // Reuse compiled pipelines from earlier runs, if any
+    const std::string pipelineCachePath = "sph_pipeline_cache.bin";
+    mynydd::loadPipelineCache(contextPtr, pipelineCachePath);
 
     // 2 Buffers are required: x_n and x_n+1
     // TODO: figure out whether vec3 or dvec3 for positions
@@ -280,8 +284,9 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
 
     uint32_t groupCount = (nParticles + 256 - 1) / 256;
     
-    auto scatterParticleData = std::make_shared<mynydd::PipelineStep>(
-        contextPtr,
+    mynydd::PipelineBuilder sphBuilder(contextPtr);
+
+    size_t scatterParticleDataIdx = sphBuilder.add(
         "examples/sph/scatter_particle_data.comp.spv", 
         std::vector<std::shared_ptr<mynydd::Buffer>>{
             pingDensityBuffer,
@@ -295,8 +300,7 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
         groupCount
     );
 
-    auto computeDensities = std::make_shared<mynydd::PipelineStep>(
-        contextPtr,
+    size_t computeDensitiesIdx = sphBuilder.add(
         "examples/sph/compute_particle_state_1.comp.spv", 
         std::vector<std::shared_ptr<mynydd::Buffer>>{
             pongDensityBuffer,
@@ -313,8 +317,7 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
         std::vector<uint32_t>{sizeof(SPHParams)}
     );
 
-    auto leapFrogStep = std::make_shared<mynydd::PipelineStep>(
-        contextPtr,
+    size_t leapFrogStepIdx = sphBuilder.add(
         "examples/sph/compute_particle_state_2.comp.spv", 
         std::vector<std::shared_ptr<mynydd::Buffer>>{
             pingDensityBuffer,
@@ -332,6 +335,12 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
         std::vector<uint32_t>{sizeof(SPHParams)}
     );
 
+    auto sphSteps = sphBuilder.build();
+    auto scatterParticleData = sphSteps[scatterParticleDataIdx];
+    auto computeDensities = sphSteps[computeDensitiesIdx];
+    auto leapFrogStep = sphSteps[leapFrogStepIdx];
+    mynydd::savePipelineCache(contextPtr, pipelineCachePath);
+
     mynydd::uploadData<dVec3Aln32>(contextPtr, inputPos, pingPosBuffer);
     mynydd::uploadData<dVec3Aln32>(contextPtr, inputVel, pingVelocityBuffer);
     mynydd::uploadData<double>(contextPtr, inputDensities, pingDensityBuffer);
@@ -357,6 +366,8 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
 
     bool write_hdf5 = true;
     uint hdf5_cadence = 10; // write every n iterations
+    uint metrics_cadence = 100; // dump runtime counters every n iterations
+    mynydd::RuntimeMetricsSnapshot lastMetrics = contextPtr->metrics->snapshot();
 
     for (uint it = 0; it < iterations; ++it) {
         auto t0 = std::chrono::high_resolution_clock::now();
@@ -407,6 +418,12 @@ SPHData run_sph_example(const SPHData& inputData, SPHParams& params, uint iterat
         index_step_times.push_back(elapsed1.count());
         density_times.push_back(elapsed2.count());
         leapfrog_times.push_back(elapsed3.count());
+        if ((it + 1) % metrics_cadence == 0) {
+            mynydd::RuntimeMetricsSnapshot metrics = contextPtr->metrics->snapshot();
+            std::cerr << std::endl << "Runtime metrics for iterations " << it + 1 - metrics_cadence
+                      << "-" << it << ": " << (metrics - lastMetrics) << std::endl;
+            lastMetrics = metrics;
+        }
         std::cout << "\r" << it << ": index=" << elapsed1.count() << "ms density=" << elapsed2.count() << "ms leapfrog=" << elapsed3.count() << "ms" << std::flush;
     }
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include <mynydd/mynydd.hpp>
+
+
+namespace mynydd {
+
+    struct CapturedBuffer {
+        VkDescriptorType type;
+        uint64_t size;
+        uint64_t range;
+        std::vector<uint8_t> contents;
+    };
+
+    struct CapturedStep {
+        std::string name;
+        std::vector<uint32_t> spirv;
+        std::array<uint32_t, 3> groupCount;
+        std::vector<uint32_t> buffers; // indices into BatchCapture::buffers, in binding order
+        uint32_t pushConstantOffset = 0;
+        std::vector<uint8_t> pushConstants;
+        std::vector<uint32_t> dynamicOffsets;
+    };
+
+    /**
+    * Everything needed to run one executeBatch call again without the application that
+    * issued it: each step's SPIR-V, dispatch size, push constants and dynamic offsets,
+    * and the contents of every buffer bound, uniforms included, as they were before the
+    * batch ran. Buffers shared between steps are stored once.
+    */
+    struct BatchCapture {
+        std::vector<CapturedBuffer> buffers;
+        std::vector<CapturedStep> steps;
+        // The batch was appended to commands recorded by the caller, which are not captured
+        bool externalCommands = false;
+    };
+
+    // Snapshots the given steps and their buffers now
+    BatchCapture captureBatch(
+        std::shared_ptr<VulkanContext> contextPtr,
+        const std::vector<std::shared_ptr<PipelineStep>>& steps,
+        bool externalCommands = false
+    );
+
+    // Arms the context so that the next executeBatch call is written to path before it runs
+    void captureNextBatch(std::shared_ptr<VulkanContext> contextPtr, const std::string& path);
+
+    void writeCapture(const BatchCapture& capture, const std::string& path);
+    BatchCapture readCapture(const std::string& path);
+
+    // Buffers and steps rebuilt from a capture, ready for executeBatch
+    struct ReplayBatch {
+        std::vector<std::shared_ptr<Buffer>> buffers;
+        std::vector<std::shared_ptr<PipelineStep>> steps;
+    };
+
+    ReplayBatch instantiateCapture(std::shared_ptr<VulkanContext> contextPtr, const BatchCapture& capture);
+
+    // Puts the captured contents back, so a batch that updates its inputs can be rerun
+    void restoreCaptureBuffers(
+        std::shared_ptr<VulkanContext> contextPtr,
+        const BatchCapture& capture,
+        const ReplayBatch& replay
+    );
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include <mynydd/mynydd.hpp>
+
+
+namespace mynydd {
+
+    /**
+    * Dependency graph of pipeline steps that runs independent branches concurrently.
+    *
+    * Each node is a PipelineStep together with the buffers it reads and writes. Nodes are
+    * added in a valid serial order (the order executeBatch would run them in); a node
+    * depends on every earlier node it has a read-after-write, write-after-read or
+    * write-after-write hazard with. Independent branches are placed on separate chains,
+    * which are spread across the context's compute queues. Chains are cut into segments
+    * wherever work crosses between them, and each segment is one submission that waits on
+    * and signals binary semaphores for its cross-segment dependencies. Within a segment,
+    * steps are separated by pipeline barriers as in executeBatch.
+    */
+    class ComputeGraph {
+        public:
+            explicit ComputeGraph(std::shared_ptr<VulkanContext> contextPtr);
+            ~ComputeGraph();
+
+            ComputeGraph(const ComputeGraph&) = delete;
+            ComputeGraph& operator=(const ComputeGraph&) = delete;
+
+            // Returns the index of the new node
+            size_t addNode(
+                std::shared_ptr<PipelineStep> step,
+                const std::vector<std::shared_ptr<Buffer>>& reads,
+                const std::vector<std::shared_ptr<Buffer>>& writes
+            );
+
+            // Record and submit every node, then block until all of them have completed
+            void execute();
+
+            size_t getNodeCount() const { return nodes.size(); }
+            // Indices of the nodes that node i must wait for
+            const std::vector<size_t>& getDependencies(size_t i) const { return nodes.at(i).deps; }
+            // Number of independent chains found; valid after execute()
+            size_t getChainCount() const { return chainCount; }
+            // Number of submissions per execute(); valid after execute()
+            size_t getSegmentCount() const { return segments.size(); }
+
+        private:
+            struct Node {
+                std::shared_ptr<PipelineStep> step;
+                std::vector<const Buffer*> reads;
+                std::vector<const Buffer*> writes;
+                std::vector<size_t> deps;
+                size_t chain = 0;
+                size_t segment = 0;
+            };
+
+            struct Segment {
+                std::vector<size_t> nodes;
+                VkQueue queue = VK_NULL_HANDLE;
+                VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+                VkFence fence = VK_NULL_HANDLE;
+                std::vector<VkSemaphore> waits;
+                std::vector<VkSemaphore> signals;
+            };
+
+            void compile();
+            void releaseSegments();
+
+            std::shared_ptr<VulkanContext> contextPtr;
+            std::vector<Node> nodes;
+            std::vector<Segment> segments; // in submission order
+            std::vector<VkSemaphore> semaphores;
+            size_t chainCount = 0;
+            bool compiled = false;
+    };
+
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+namespace mynydd {
+
+    /**
+    * Fixed set of worker threads that run index ranges in parallel. The calling thread
+    * takes part, so a pool of one thread runs everything inline.
+    */
+    class ThreadPool {
+        public:
+            explicit ThreadPool(unsigned nThreads = std::thread::hardware_concurrency());
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+            // Calls body(i, worker) for every i in [0, count); worker is in [0, size()).
+            // The first exception thrown by body is rethrown once every index has run.
+            void parallelFor(uint32_t count, const std::function<void(uint32_t, unsigned)>& body);
+
+        private:
+            void workerLoop(unsigned worker);
+            void runChunks(unsigned worker);
+
+            std::vector<std::thread> workers;
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable done;
+            const std::function<void(uint32_t, unsigned)>* job = nullptr;
+            uint32_t jobCount = 0;
+            std::atomic<uint32_t> next{0};
+            uint64_t generation = 0;
+            unsigned busy = 0;
+            bool stopping = false;
+            std::exception_ptr error;
+    };
+
+    // Host execution resources shared by CPU steps, the counterpart of VulkanContext
+    struct CpuContext {
+        ThreadPool pool;
+
+        explicit CpuContext(unsigned nThreads = std::thread::hardware_concurrency()) : pool(nThreads) {}
+    };
+
+    // Host memory bound to a CPU step, the counterpart of Buffer
+    class CpuBuffer {
+        public:
+            explicit CpuBuffer(size_t size) : storage(size) {}
+
+            size_t getSize() const { return storage.size(); }
+            std::byte* data() { return storage.data(); }
+            const std::byte* data() const { return storage.data(); }
+
+        private:
+            std::vector<std::byte> storage;
+    };
+
+    // Built-in IDs of one invocation, named after their GLSL equivalents
+    struct Invocation {
+        glm::uvec3 globalInvocationID;
+        glm::uvec3 localInvocationID;
+        glm::uvec3 workGroupID;
+        uint32_t localInvocationIndex;
+    };
+
+    /**
+    * What a CPU kernel sees while running one workgroup.
+    *
+    * Kernels are written as a sequence of forEachInvocation calls; returning from one
+    * call and starting the next is the barrier(), since every invocation of the group
+    * has finished the first loop before any starts the second. Shared memory allocated
+    * with shared() lives until the workgroup ends and, as on the GPU, is not cleared.
+    * It comes from a fixed arena of the step's declared shared memory size, so earlier
+    * arrays stay where they are when later ones are allocated.
+    */
+    class Workgroup {
+        public:
+            Workgroup(
+                glm::uvec3 workGroupID,
+                glm::uvec3 numWorkGroups,
+                glm::uvec3 localSize,
+                const std::vector<std::shared_ptr<CpuBuffer>>& buffers,
+                const std::vector<std::byte>& pushConstants,
+                std::byte* sharedArena,
+                size_t sharedSize
+            ) : workGroupID(workGroupID), numWorkGroups(numWorkGroups), localSize(localSize),
+                buffers(buffers), pushConstantBytes(pushConstants), sharedArena(sharedArena), sharedSize(sharedSize) {}
+
+            const glm::uvec3 workGroupID;
+            const glm::uvec3 numWorkGroups;
+            const glm::uvec3 localSize;
+
+            template<typename F>
+            void forEachInvocation(F&& body) const {
+                Invocation inv;
+                inv.workGroupID = workGroupID;
+                uint32_t index = 0;
+                for (uint32_t z = 0; z < localSize.z; ++z) {
+                    for (uint32_t y = 0; y < localSize.y; ++y) {
+                        // Innermost loop over x is the one the compiler can vectorise
+                        for (uint32_t x = 0; x < localSize.x; ++x, ++index) {
+                            inv.localInvocationID = glm::uvec3(x, y, z);
+                            inv.globalInvocationID = workGroupID * localSize + inv.localInvocationID;
+                            inv.localInvocationIndex = index;
+                            body(inv);
+                        }
+                    }
+                }
+            }
+
+            // Buffer bound at the given binding, viewed as an array of T
+            template<typename T>
+            T* binding(size_t index) const {
+                if (index >= buffers.size()) {
+                    throw std::runtime_error("No CPU buffer bound at binding " + std::to_string(index));
+                }
+                return reinterpret_cast<T*>(buffers[index]->data());
+            }
+
+            template<typename T>
+            T pushConstants() const {
+                static_assert(std::is_trivially_copyable_v<T>, "Push constant data must be trivially copyable");
+                if (pushConstantBytes.size() < sizeof(T)) {
+                    throw std::runtime_error("Push constants requested but they don't exist.");
+                }
+                T value;
+                std::memcpy(&value, pushConstantBytes.data(), sizeof(T));
+                return value;
+            }
+
+            template<typename T>
+            T* shared(size_t count) {
+                static_assert(alignof(T) <= alignof(std::max_align_t), "Shared memory type is over-aligned");
+                size_t offset = (sharedUsed + alignof(T) - 1) / alignof(T) * alignof(T);
+                if (offset + count * sizeof(T) > sharedSize) {
+                    throw std::runtime_error(
+                        "Workgroup shared memory (" + std::to_string(offset + count * sizeof(T)) +
+                        " bytes) exceeds the step's declared size (" + std::to_string(sharedSize) + " bytes)"
+                    );
+                }
+                sharedUsed = offset + count * sizeof(T);
+                return reinterpret_cast<T*>(sharedArena + offset);
+            }
+
+        private:
+            const std::vector<std::shared_ptr<CpuBuffer>>& buffers;
+            const std::vector<std::byte>& pushConstantBytes;
+            std::byte* sharedArena;
+            size_t sharedSize;
+            size_t sharedUsed = 0;
+    };
+
+    using CpuKernel = std::function<void(Workgroup&)>;
+
+    /**
+    * A kernel dispatch on the CPU, the counterpart of PipelineStep. Workgroups are
+    * spread across the context thread pool; invocations within a workgroup run in
+    * order on one thread.
+    */
+    class CpuPipelineStep {
+        public:
+            CpuPipelineStep(
+                std::shared_ptr<CpuContext> contextPtr,
+                CpuKernel kernel,
+                std::vector<std::shared_ptr<CpuBuffer>> buffers,
+                glm::uvec3 localSize,
+                uint32_t groupCountX,
+                uint32_t groupCountY=1,
+                uint32_t groupCountZ=1
+            ) : groupCountX(groupCountX), groupCountY(groupCountY), groupCountZ(groupCountZ),
+                contextPtr(contextPtr), kernel(std::move(kernel)), buffers(std::move(buffers)), localSize(localSize) {
+                if (localSize.x == 0 || localSize.y == 0 || localSize.z == 0) {
+                    throw std::runtime_error("CPU step local size must be non-zero");
+                }
+            }
+
+            uint32_t groupCountX;
+            uint32_t groupCountY;
+            uint32_t groupCountZ;
+
+            template<typename PCT>
+            void setPushConstantsData(const PCT &value) {
+                static_assert(std::is_trivially_copyable_v<PCT>,
+                            "Push constant data must be trivially copyable");
+                pushConstants.resize(sizeof(PCT));
+                std::memcpy(pushConstants.data(), &value, sizeof(PCT));
+            }
+
+            void setBuffers(std::vector<std::shared_ptr<CpuBuffer>> newBuffers) {
+                buffers = std::move(newBuffers);
+            }
+
+            const glm::uvec3& getLocalSize() const { return localSize; }
+
+            // Bytes of shared() memory each workgroup may use, the CPU counterpart of the
+            // shared variables a shader declares
+            void setSharedMemorySize(size_t bytes) { sharedMemorySize = bytes; }
+            size_t getSharedMemorySize() const { return sharedMemorySize; }
+
+            // Sets a 1D dispatch with just enough workgroups to cover nElements invocations
+            void dispatchForElements(uint64_t nElements) {
+                groupCountX = static_cast<uint32_t>((nElements + localSize.x - 1) / localSize.x);
+                groupCountY = 1;
+                groupCountZ = 1;
+            }
+
+            void execute();
+
+        private:
+            std::shared_ptr<CpuContext> contextPtr;
+            CpuKernel kernel;
+            std::vector<std::shared_ptr<CpuBuffer>> buffers;
+            std::vector<std::byte> pushConstants;
+            glm::uvec3 localSize;
+            size_t sharedMemorySize = 32 * 1024; // what most GPUs offer a workgroup
+    };
+
+    // Runs the steps in order; each step completes before the next starts
+    void executeBatch(
+        std::shared_ptr<CpuContext> contextPtr,
+        const std::vector<std::shared_ptr<CpuPipelineStep>>& steps
+    );
+
+    template<typename T>
+    void uploadData(std::shared_ptr<CpuContext>, const std::vector<T> &inputData, std::shared_ptr<CpuBuffer> buffer) {
+        if (inputData.empty()) {
+            throw std::runtime_error("Data vector is empty");
+        }
+        if (sizeof(T) * inputData.size() > buffer->getSize()) {
+            throw std::runtime_error("Data size exceeds allocated buffer size");
+        }
+        std::memcpy(buffer->data(), inputData.data(), sizeof(T) * inputData.size());
+    }
+
+    template<typename T>
+    std::vector<T> fetchData(std::shared_ptr<CpuContext>, std::shared_ptr<CpuBuffer> buffer, size_t n_elements) {
+        if (sizeof(T) * n_elements > buffer->getSize()) {
+            throw std::runtime_error("Requested more data than the buffer holds");
+        }
+        const T* data = reinterpret_cast<const T*>(buffer->data());
+        return std::vector<T>(data, data + n_elements);
+    }
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace mynydd {
+
+    struct EmbeddedShader {
+        const char* name; // file name without .spv, e.g. "histogram.comp"
+        const uint32_t* code;
+        size_t wordCount;
+    };
+
+    // Defined in the source generated at build time by cmake/embed_shaders.cmake
+    extern const EmbeddedShader embeddedShaders[];
+    extern const size_t embeddedShaderCount;
+
+    /**
+    * SPIR-V of a library shader compiled into libmynydd, so library pipelines do not
+    * depend on the working directory. Throws if no shader of that name was embedded.
+    */
+    std::vector<uint32_t> getEmbeddedShader(const std::string& name);
+
+}
@@ -3,9 +3,15 @@
 #include <assert.h>
 #include <cstring>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
+#include <mynydd/metrics.hpp>
+
 
 namespace mynydd {
     struct VulkanContext;
@@ -16,13 +22,30 @@ namespace mynydd {
 
         Buffer(std::shared_ptr<VulkanContext> vkc, size_t size, bool uniform=false);
 
+        // range is the window seen by a single descriptor; dynamic uniform buffers bind
+        // one block of the buffer at a time, selected by a per-dispatch dynamic offset
+        Buffer(
+            std::shared_ptr<VulkanContext> vkc,
+            size_t size,
+            VkDescriptorType type,
+            VkDeviceSize range = VK_WHOLE_SIZE
+        );
+
+        // A window of parent starting at offset, e.g. one chunk of an array too large for a
+        // single storage binding. The view keeps parent alive and never frees its memory.
+        // offset must be a multiple of minStorageBufferOffsetAlignment to be bound.
+        Buffer(std::shared_ptr<Buffer> parent, VkDeviceSize offset, VkDeviceSize size);
+
         // Prevent copying
         Buffer(const Buffer&) = delete;
         Buffer& operator=(const Buffer&) = delete;
 
         // Move implementation
         Buffer(Buffer&& other) noexcept
-            : device(other.device), buffer(other.buffer), memory(other.memory), size(other.size) {
+            : device(other.device), buffer(other.buffer), memory(other.memory), size(other.size),
+              type(other.type), range(other.range), deviceAddress(other.deviceAddress),
+              offset(other.offset), parent(std::move(other.parent)) {
+            other.deviceAddress = 0;
             other.buffer = VK_NULL_HANDLE;
             other.memory = VK_NULL_HANDLE;
         }
@@ -34,7 +57,13 @@ namespace mynydd {
                 buffer = other.buffer;
                 memory = other.memory;
                 size = other.size;
+                type = other.type;
+                range = other.range;
+                deviceAddress = other.deviceAddress;
+                offset = other.offset;
+                parent = std::move(other.parent);
 
+                other.deviceAddress = 0;
                 other.buffer = VK_NULL_HANDLE;
                 other.memory = VK_NULL_HANDLE;
             }
@@ -48,7 +77,27 @@ namespace mynydd {
         VkBuffer getBuffer() const { return buffer; }
         VkDeviceMemory getMemory() const { return memory; }
         VkDeviceSize getSize() const { return size; }
+        // Start of this buffer within its VkBuffer and memory; non-zero only for views
+        VkDeviceSize getOffset() const { return offset; }
+        bool isView() const { return parent != nullptr; }
         VkDescriptorType getType() const { return type; }
+        VkDeviceSize getRange() const { return range == VK_WHOLE_SIZE ? size : range; }
+        bool isDynamic() const { return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; }
+        bool hasDeviceAddress() const { return deviceAddress != 0; }
+        // True if both refer to some of the same bytes, e.g. a view and its parent
+        bool overlaps(const Buffer& other) const {
+            return buffer == other.buffer && buffer != VK_NULL_HANDLE
+                && offset < other.offset + other.size && other.offset < offset + size;
+        }
+
+        // GPU virtual address of a storage buffer, for shaders using GL_EXT_buffer_reference.
+        // Only available when the context enabled buffer device addresses.
+        VkDeviceAddress getDeviceAddress() const {
+            if (deviceAddress == 0) {
+                throw std::runtime_error("Buffer has no device address; buffer device address is unsupported or this is a uniform buffer");
+            }
+            return deviceAddress;
+        }
 
         explicit operator bool() const { return buffer != VK_NULL_HANDLE; }
 
@@ -58,17 +107,101 @@ namespace mynydd {
         VkDeviceMemory memory = VK_NULL_HANDLE;
         VkDeviceSize size = 0;
         VkDescriptorType type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-
+        VkDeviceSize range = VK_WHOLE_SIZE;
+        VkDeviceAddress deviceAddress = 0;
+        VkDeviceSize offset = 0;
+        std::shared_ptr<Buffer> parent; // set for views, which own nothing
 
         void destroy() {
-            if (buffer != VK_NULL_HANDLE) {
-                vkDestroyBuffer(device, buffer, nullptr);
-            }
-            if (memory != VK_NULL_HANDLE) {
-                vkFreeMemory(device, memory, nullptr);
+            if (parent) {
+                parent.reset();
+            } else {
+                if (buffer != VK_NULL_HANDLE) {
+                    vkDestroyBuffer(device, buffer, nullptr);
+                }
+                if (memory != VK_NULL_HANDLE) {
+                    vkFreeMemory(device, memory, nullptr);
+                }
             }
             buffer = VK_NULL_HANDLE;
             memory = VK_NULL_HANDLE;
         }
     };
+
+    /**
+    * Largest number of elements one storage binding can show, per maxStorageBufferRange,
+    * for each of the given element sizes. Rounded down so that consecutive chunks of
+    * that many elements start on a multiple of minStorageBufferOffsetAlignment in every
+    * array, which lets arrays indexed in lockstep be chunked together.
+    */
+    uint64_t maxElementsPerBinding(std::shared_ptr<VulkanContext> vkc, const std::vector<size_t>& elementSizes);
+
+    // Consecutive views of buffer holding at most elementsPerChunk elements each
+    std::vector<std::shared_ptr<Buffer>> splitBuffer(
+        std::shared_ptr<Buffer> buffer,
+        size_t elementSize,
+        uint64_t elementsPerChunk
+    );
+
+    /**
+    * Ring of uniform parameter blocks in one persistently mapped dynamic uniform buffer.
+    *
+    * Every push() copies a parameter struct into its own aligned block and returns the
+    * dynamic offset of that block. Since earlier blocks are never overwritten in place,
+    * many parameterised dispatches of the same pipeline can be recorded into one command
+    * buffer without host synchronisation in between. Blocks are only reused after a full
+    * wrap of the ring; release() marks all pushed blocks as consumed by the GPU.
+    */
+    class UniformRing {
+    public:
+        UniformRing(
+            std::shared_ptr<VulkanContext> vkc,
+            VkDeviceSize blockSize = 256,
+            uint32_t blockCount = 1024
+        );
+        ~UniformRing();
+
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        template<typename U>
+        uint32_t push(const U& uniform) {
+            static_assert(std::is_trivially_copyable_v<U>, "Uniform data must be trivially copyable");
+            if (sizeof(U) > blockSize) {
+                throw std::runtime_error(
+                    "Uniform size (" + std::to_string(sizeof(U)) +
+                    " bytes) exceeds uniform ring block size (" +
+                    std::to_string(blockSize) + " bytes)!"
+                );
+            }
+            if (pending == blockCount) {
+                throw std::runtime_error("Uniform ring exhausted: submit and release before pushing more blocks");
+            }
+            uint32_t offset = static_cast<uint32_t>(head * blockSize);
+            std::memcpy(static_cast<char*>(mapped) + offset, &uniform, sizeof(U));
+            RuntimeMetrics::count(metrics->bytesUploaded, sizeof(U));
+            head = (head + 1) % blockCount;
+            ++pending;
+            return offset;
+        }
+
+        // Call once the GPU has finished with every block pushed so far
+        void release() { pending = 0; }
+
+        std::shared_ptr<Buffer> getBuffer() const { return buffer; }
+        VkDeviceSize getBlockSize() const { return blockSize; }
+        uint32_t getBlockCount() const { return blockCount; }
+        // The ring stays mapped for its lifetime, so read it here rather than mapping it again
+        const void* getMappedData() const { return mapped; }
+
+    private:
+        VkDevice device = VK_NULL_HANDLE;
+        std::shared_ptr<RuntimeMetrics> metrics;
+        std::shared_ptr<Buffer> buffer;
+        void* mapped = nullptr;
+        VkDeviceSize blockSize;
+        uint32_t blockCount;
+        uint32_t head = 0;
+        uint32_t pending = 0;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+
+namespace mynydd {
+
+    /**
+    * Plain copy of the runtime counters at one point in time. Subtract two snapshots
+    * to get the activity in between, e.g. for a single simulation step.
+    */
+    struct RuntimeMetricsSnapshot {
+        uint64_t submits = 0;                 // vkQueueSubmit calls that succeeded
+        uint64_t fenceWaits = 0;              // vkWaitForFences calls
+        uint64_t fenceWaitNs = 0;             // host time spent blocked in those waits
+        uint64_t barriers = 0;                // vkCmdPipelineBarrier calls recorded
+        uint64_t descriptorPoolsCreated = 0;
+        uint64_t descriptorSetsAllocated = 0;
+        uint64_t bytesUploaded = 0;           // through uploadData / uploadUniformData / the uniform ring
+        uint64_t bytesDownloaded = 0;         // through fetchData
+        uint64_t mapCalls = 0;
+        uint64_t unmapCalls = 0;
+
+        RuntimeMetricsSnapshot operator-(const RuntimeMetricsSnapshot& earlier) const;
+    };
+
+    std::ostream& operator<<(std::ostream& os, const RuntimeMetricsSnapshot& snapshot);
+
+    /**
+    * Always-on counters for host-side overhead, held by the VulkanContext. Updates are
+    * relaxed atomic increments, so counting costs next to nothing on the hot path.
+    */
+    class RuntimeMetrics {
+        public:
+            std::atomic<uint64_t> submits{0};
+            std::atomic<uint64_t> fenceWaits{0};
+            std::atomic<uint64_t> fenceWaitNs{0};
+            std::atomic<uint64_t> barriers{0};
+            std::atomic<uint64_t> descriptorPoolsCreated{0};
+            std::atomic<uint64_t> descriptorSetsAllocated{0};
+            std::atomic<uint64_t> bytesUploaded{0};
+            std::atomic<uint64_t> bytesDownloaded{0};
+            std::atomic<uint64_t> mapCalls{0};
+            std::atomic<uint64_t> unmapCalls{0};
+
+            static void count(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+                counter.fetch_add(n, std::memory_order_relaxed);
+            }
+
+            RuntimeMetricsSnapshot snapshot() const;
+            void reset();
+    };
+
+}
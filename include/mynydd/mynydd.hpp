@@ -1,15 +1,22 @@
 #pragma once
 
+#include <array>
 #include <assert.h>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
 #include <mynydd/memory.hpp>
+#include <mynydd/metrics.hpp>
+#include <mynydd/roofline.hpp>
+#include <mynydd/spirv_reflect.hpp>
+#include <mynydd/tracer.hpp>
 
 
 namespace mynydd {
@@ -24,16 +31,29 @@ namespace mynydd {
         VkPhysicalDevice physicalDevice;
         VkDevice device; // logical device used for interface
         VkQueue computeQueue; // compute queue used for commands
+        std::vector<VkQueue> computeQueues; // all queues created on the compute family; [0] is computeQueue
         uint32_t computeQueueFamilyIndex;
         VkCommandPool commandPool;
         VkCommandBuffer commandBuffer;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE; // used for every pipeline created on this context
+        std::shared_ptr<UniformRing> uniformRing; // created on first use, see getUniformRing
+        bool bufferDeviceAddress = false; // VK_KHR_buffer_device_address available and enabled
+        PFN_vkGetBufferDeviceAddressKHR getBufferDeviceAddress = nullptr;
+        std::shared_ptr<Tracer> tracer; // null unless tracing is on, see enableTracing
+        std::shared_ptr<RuntimeMetrics> metrics = std::make_shared<RuntimeMetrics>(); // always on
+        std::string capturePath; // if set, the next executeBatch is captured here, see captureNextBatch
 
         VulkanContext(bool validationn=true);
 
         ~VulkanContext() {
+            uniformRing.reset(); // owns device memory, so must go before the device
+            tracer.reset(); // owns a query pool
             if (commandBuffer != VK_NULL_HANDLE) {
                 vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
             }
+            if (pipelineCache != VK_NULL_HANDLE) {
+                vkDestroyPipelineCache(device, pipelineCache, nullptr);
+            }
             if (commandPool != VK_NULL_HANDLE) {
                 vkDestroyCommandPool(device, commandPool, nullptr);
             }
@@ -68,6 +88,18 @@ namespace mynydd {
 
     VulkanContext createVulkanContext();
 
+    /**
+    * Returns the context-level uniform ring, creating it on first use.
+    */
+    std::shared_ptr<UniformRing> getUniformRing(std::shared_ptr<VulkanContext> contextPtr);
+
+    /**
+    * Seeds the context pipeline cache from a file written by savePipelineCache.
+    * Returns false if the file is missing; stale or foreign data is ignored by the driver.
+    */
+    bool loadPipelineCache(std::shared_ptr<VulkanContext> contextPtr, const std::string& path);
+    void savePipelineCache(std::shared_ptr<VulkanContext> contextPtr, const std::string& path);
+
     // TODO: this is some dangerous nonsense
     struct PushConstantData {
         uint32_t offset;
@@ -77,15 +109,15 @@ namespace mynydd {
 
     struct VulkanDynamicResources {
         std::shared_ptr<VulkanContext> contextPtr;
-        VkDescriptorSetLayout descriptorSetLayout;
-        VkDescriptorPool descriptorPool;
-        VkDescriptorSet descriptorSet;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
         VulkanDynamicResources(
             std::shared_ptr<VulkanContext> contextPtr,
             std::vector<std::shared_ptr<Buffer>> buffers
         );
         ~VulkanDynamicResources() {
-            if (contextPtr && contextPtr->device != VK_NULL_HANDLE && descriptorPool != VK_NULL_HANDLE) {
+            if (contextPtr && contextPtr->device != VK_NULL_HANDLE && descriptorSetLayout != VK_NULL_HANDLE) {
             } else {
                 std::cerr << "VulkanDynamicResources destructor failure due to invalid dependency handles." << std::endl;
             }
@@ -98,6 +130,13 @@ namespace mynydd {
         VulkanDynamicResources& operator=(VulkanDynamicResources&&) = default;     // Allow move
     };
 
+    /**
+    * A single compute dispatch: shader, bound buffers and workgroup counts.
+    *
+    * Buffers are bound positionally to set 0. A step may also be created with no
+    * buffers at all, in which case the shader reaches its data through buffer device
+    * addresses passed in push constants (see Buffer::getDeviceAddress).
+    */
     class PipelineStep {
         public:
             PipelineStep(
@@ -109,7 +148,48 @@ namespace mynydd {
                 uint32_t groupCountZ=1,
                 std::vector<uint32_t> pushConstantSizes = {}
             ); 
+            // From SPIR-V already in memory, e.g. getEmbeddedShader(); name is used in messages
+            PipelineStep(
+                std::shared_ptr<VulkanContext> contextPtr,
+                const std::vector<uint32_t>& spirv,
+                const std::string& name,
+                std::vector<std::shared_ptr<Buffer>> buffers,
+                uint32_t groupCountX,
+                uint32_t groupCountY=1,
+                uint32_t groupCountZ=1,
+                std::vector<uint32_t> pushConstantSizes = {}
+            );
+            // Adopts descriptor and pipeline resources that were created elsewhere, e.g.
+            // by PipelineBuilder; the step takes ownership of the pipeline resources
+            PipelineStep(
+                std::shared_ptr<VulkanContext> contextPtr,
+                std::shared_ptr<VulkanDynamicResources> dynamicResources,
+                VulkanPipelineResources pipelineResources,
+                ShaderReflection reflection,
+                const std::vector<std::shared_ptr<Buffer>>& buffers,
+                uint32_t groupCountX,
+                uint32_t groupCountY=1,
+                uint32_t groupCountZ=1,
+                const std::string& name = "",
+                std::vector<uint32_t> spirv = {}
+            );
             ~PipelineStep();
+            std::shared_ptr<VulkanContext> getContextPtr() const {
+                return contextPtr;
+            }
+            // Shader path or name given at construction; labels the step in traces
+            const std::string& getName() const {
+                return m_name;
+            }
+            void setName(const std::string& name) {
+                m_name = name;
+            }
+            // SPIR-V the step was created from; empty if the creator did not provide it
+            const std::vector<uint32_t>& getSpirv() const {
+                return m_spirv;
+            }
+            // Buffers bound positionally to set 0; throws if one has been destroyed
+            std::vector<std::shared_ptr<Buffer>> getBuffers() const;
             std::shared_ptr<VulkanPipelineResources> getPipelineResourcesPtr() const {
                 return pipelineResources;
             }
@@ -125,6 +205,34 @@ namespace mynydd {
             bool hasPushConstantData() {
                 return m_pushConstantData.size > 0;
             }
+            // Bindings, push-constant size and workgroup size read from the shader's SPIR-V
+            const ShaderReflection& getReflection() const {
+                return m_reflection;
+            }
+            const std::array<uint32_t, 3>& getLocalSize() const {
+                return m_reflection.localSize;
+            }
+            // Sets a dispatch with just enough workgroups to cover nElements invocations.
+            // Above maxComputeWorkGroupCount[0] workgroups the grid is folded into 2D, so
+            // the shader must index with linearInvocationID() from dispatch.comp.kern
+            // and bounds-check, since the last row may be partly idle
+            void dispatchForElements(uint64_t nElements);
+            void setGroupCount(const std::array<uint32_t, 3>& groupCount) {
+                groupCountX = groupCount[0];
+                groupCountY = groupCount[1];
+                groupCountZ = groupCount[2];
+            }
+            // Bytes and operations per dispatch, used for roofline reports. Returns the
+            // declared model if one was set, otherwise estimateWorkloadModel()
+            WorkloadModel getWorkloadModel() const {
+                return m_workloadModel ? *m_workloadModel : estimateWorkloadModel();
+            }
+            void setWorkloadModel(const WorkloadModel& model) {
+                m_workloadModel = model;
+            }
+            // Every read-only binding read in full, every write-only binding written in
+            // full, read-write bindings both, and one operation per invocation
+            WorkloadModel estimateWorkloadModel() const;
             // TODO: make private
             uint32_t groupCountX;
             uint32_t groupCountY;
@@ -133,6 +241,35 @@ namespace mynydd {
                 std::shared_ptr<VulkanContext> contextPtr,
                 const std::vector<std::shared_ptr<Buffer>>& buffers
             );
+            // One offset per dynamic uniform binding, in binding order
+            void setDynamicOffsets(const std::vector<uint32_t>& offsets) {
+                if (offsets.size() != m_dynamicOffsets.size()) {
+                    throw std::runtime_error(
+                        "Expected " + std::to_string(m_dynamicOffsets.size()) +
+                        " dynamic offsets, got " + std::to_string(offsets.size())
+                    );
+                }
+                m_dynamicOffsets = offsets;
+            }
+            const std::vector<uint32_t>& getDynamicOffsets() const {
+                return m_dynamicOffsets;
+            }
+            // Sub-allocate a parameter block from the context uniform ring for the
+            // dynamic uniform binding with the given index. The offset is captured when
+            // the step is recorded, so the step can be pushed and recorded repeatedly.
+            template<typename U>
+            void pushUniformData(const U &value, size_t dynamicIndex = 0) {
+                if (dynamicIndex >= m_dynamicOffsets.size()) {
+                    throw std::runtime_error("Step has no dynamic uniform binding " + std::to_string(dynamicIndex));
+                }
+                m_dynamicOffsets[dynamicIndex] = getUniformRing(contextPtr)->push(value);
+            }
+            void setPushConstantsBytes(const void* data, uint32_t size, uint32_t offset = 0) {
+                m_pushConstantData.push_data.resize(size);
+                std::memcpy(m_pushConstantData.push_data.data(), data, size);
+                m_pushConstantData.offset = offset;
+                m_pushConstantData.size = size;
+            }
             template<typename PCT>
             void setPushConstantsData(const PCT &value, uint32_t offset = 0) {
                 static_assert(std::is_trivially_copyable_v<PCT>,
@@ -150,21 +287,71 @@ namespace mynydd {
             std::shared_ptr<VulkanPipelineResources> pipelineResources;
 
             PushConstantData m_pushConstantData{0, 0, std::vector<std::byte>{}};
+            std::vector<uint32_t> m_dynamicOffsets;
+            ShaderReflection m_reflection;
+            std::string m_name;
+            std::vector<VkDeviceSize> m_bindingSizes; // bytes visible through each binding
+            std::vector<std::weak_ptr<Buffer>> m_buffers; // not owned, as with the descriptor set
+            std::vector<uint32_t> m_spirv;
+            std::optional<WorkloadModel> m_workloadModel;
     };
 
 
+    /**
+    * Workgroup counts covering at least groups workgroups within the device limits: 1D
+    * while groups fits in maxComputeWorkGroupCount[0], otherwise folded into 2D. Kernels
+    * recover the 1D index with linearWorkGroupID() from dispatch.comp.kern.
+    */
+    std::array<uint32_t, 3> foldGroupCount(uint64_t groups, uint32_t maxGroupCountX, uint32_t maxGroupCountY);
+    std::array<uint32_t, 3> foldGroupCount(std::shared_ptr<VulkanContext> contextPtr, uint64_t groups);
+
     VkBuffer createBuffer(VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage);
+    VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool pool);
+    std::vector<uint32_t> readShaderFile(const char *filepath);
+    VkShaderModule createShaderModule(VkDevice device, const std::vector<uint32_t> &code);
+    VkPipelineLayout createPipelineLayout(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        VkDescriptorSetLayout descriptorSetLayout,
+        const std::vector<uint32_t> &pushConstantSizes
+    );
+    VkComputePipelineCreateInfo computePipelineCreateInfo(
+        VkShaderModule shaderModule,
+        VkPipelineLayout pipelineLayout
+    );
     VkDeviceMemory allocateAndBindMemory(
         VkPhysicalDevice physicalDevice,
         VkDevice device,
         VkBuffer buffer,
-        VkMemoryPropertyFlags properties
+        VkMemoryPropertyFlags properties,
+        VkMemoryAllocateFlags allocateFlags = 0
+    );
+    void recordCommandBuffer(
+        VkCommandBuffer cmdBuffer,
+        std::shared_ptr<PipelineStep> pipeline_step,
+        bool memory_barrier = true
+    );
+    /**
+    * Records a fill of buffer (or of the range a view covers) with value, fenced by
+    * barriers so that it runs after earlier compute work and before later compute work.
+    */
+    void recordFillBuffer(
+        VkCommandBuffer cmdBuffer,
+        std::shared_ptr<VulkanContext> contextPtr,
+        std::shared_ptr<Buffer> buffer,
+        uint32_t value = 0
     );
     void executeBatch(
         std::shared_ptr<VulkanContext> contextPtr,
         const std::vector<std::shared_ptr<PipelineStep>>& PipelineSteps,
         bool beginCommandBuffer = true
     );
+    /**
+    * Ends the context command buffer, submits it and blocks until the GPU is done, then
+    * releases the uniform ring. For work recorded directly with recordCommandBuffer or
+    * a pipeline's record(); executeBatch finishes with the same call.
+    */
+    void submitAndWait(std::shared_ptr<VulkanContext> contextPtr);
 
 };
 
@@ -19,10 +19,10 @@ namespace mynydd {
     };
 
     template<typename T>
-    void uploadBufferData(VkDevice device, VkDeviceMemory memory, const std::vector<T>& inputData) {
+    void uploadBufferData(VkDevice device, VkDeviceMemory memory, const std::vector<T>& inputData, VkDeviceSize offset = 0) {
         void* mapped;
         VkDeviceSize size = sizeof(T) * inputData.size();
-        if (vkMapMemory(device, memory, 0, size, 0, &mapped) != VK_SUCCESS) {
+        if (vkMapMemory(device, memory, offset, size, 0, &mapped) != VK_SUCCESS) {
             throw std::runtime_error("Failed to map buffer memory for upload");
         }
 
@@ -39,33 +39,40 @@ namespace mynydd {
                 std::to_string(buff->getSize()) + " bytes)!"
             );
         }
+        TraceScope scope(vkc->tracer.get(), "upload uniform");
         void* mapped;
         VkDeviceSize size = sizeof(U);
 
-        if (vkMapMemory(vkc->device, buff->getMemory(), 0, size, 0, &mapped) != VK_SUCCESS) {
+        RuntimeMetrics::count(vkc->metrics->mapCalls);
+        if (vkMapMemory(vkc->device, buff->getMemory(), buff->getOffset(), size, 0, &mapped) != VK_SUCCESS) {
             throw std::runtime_error("Failed to map uniform buffer memory for upload");
         }
 
         std::memcpy(mapped, &uniform, static_cast<size_t>(size));
         vkUnmapMemory(vkc->device, buff->getMemory());
+        RuntimeMetrics::count(vkc->metrics->unmapCalls);
+        RuntimeMetrics::count(vkc->metrics->bytesUploaded, size);
     }
 
 
     template<typename T>
     void uploadData(std::shared_ptr<VulkanContext> vkc, const std::vector<T> &inputData, std::shared_ptr<Buffer> buffer) {
+        TraceScope scope(vkc->tracer.get(), "upload");
         try {
             if (inputData.empty()) {
                 throw std::runtime_error("Data vector is empty");
             }
 
-            size_t numElements = static_cast<uint32_t>(inputData.size());
-            size_t dataSize = sizeof(T) * numElements;
+            size_t dataSize = sizeof(T) * inputData.size();
 
             if (dataSize > buffer->getSize()) {
                 throw std::runtime_error("Data size exceeds allocated buffer size");
             }
 
-            uploadBufferData<T>(vkc->device, buffer->getMemory(), inputData);
+            uploadBufferData<T>(vkc->device, buffer->getMemory(), inputData, buffer->getOffset());
+            RuntimeMetrics::count(vkc->metrics->mapCalls);
+            RuntimeMetrics::count(vkc->metrics->unmapCalls);
+            RuntimeMetrics::count(vkc->metrics->bytesUploaded, dataSize);
         }
         catch (const std::exception& e) {
             std::cerr << "Exception in uploadData: " << e.what() << std::endl;
@@ -77,9 +84,17 @@ namespace mynydd {
     * Maps Vulkan device memory and copies data into a CPU vector.
     */
     template<typename T>
-    std::vector<T> readBufferData(VkDevice device, VkDeviceMemory memory, VkDeviceSize dataSize, uint32_t numElements) {
+    std::vector<T> readBufferData(
+        VkDevice device,
+        VkDeviceMemory memory,
+        VkDeviceSize dataSize,
+        size_t numElements,
+        VkDeviceSize offset = 0
+    ) {
         void* mappedData;
-        vkMapMemory(device, memory, 0, dataSize, 0, &mappedData);
+        if (vkMapMemory(device, memory, offset, dataSize, 0, &mappedData) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to map buffer memory for download");
+        }
 
         T* data = reinterpret_cast<T*>(mappedData);
         std::vector<T> result(data, data + numElements);
@@ -90,13 +105,21 @@ namespace mynydd {
 
     template<typename T>
     std::vector<T> fetchData(std::shared_ptr<VulkanContext> vkc, std::shared_ptr<Buffer> buffer, size_t n_elements) {
+        TraceScope scope(vkc->tracer.get(), "fetch");
+        if (sizeof(T) * n_elements > buffer->getSize()) {
+            throw std::runtime_error("Requested more data than the buffer holds");
+        }
 
         std::vector<T> output = readBufferData<T>(
             vkc->device,
             buffer->getMemory(),
             buffer->getSize(),
-            n_elements
+            n_elements,
+            buffer->getOffset()
         );
+        RuntimeMetrics::count(vkc->metrics->mapCalls);
+        RuntimeMetrics::count(vkc->metrics->unmapCalls);
+        RuntimeMetrics::count(vkc->metrics->bytesDownloaded, sizeof(T) * n_elements);
 
         return output;
     }
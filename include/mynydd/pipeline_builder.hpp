@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include <mynydd/mynydd.hpp>
+
+
+namespace mynydd {
+
+    /**
+    * Creates many PipelineSteps at once.
+    *
+    * Steps are described with add(), which takes the same arguments as the PipelineStep
+    * constructor and returns the index of the step in the vector returned by build().
+    * build() reads the SPIR-V files that are not already in memory in parallel and
+    * creates every pipeline in a single vkCreateComputePipelines call against the
+    * context pipeline cache, instead of one file read and one driver compile per step
+    * on the calling thread.
+    */
+    class PipelineBuilder {
+        public:
+            explicit PipelineBuilder(std::shared_ptr<VulkanContext> contextPtr);
+
+            size_t add(
+                const char* shaderPath,
+                std::vector<std::shared_ptr<Buffer>> buffers,
+                uint32_t groupCountX,
+                uint32_t groupCountY=1,
+                uint32_t groupCountZ=1,
+                std::vector<uint32_t> pushConstantSizes = {}
+            );
+
+            // Same as above for SPIR-V already in memory, e.g. getEmbeddedShader()
+            size_t add(
+                const std::vector<uint32_t>& spirv,
+                const std::string& name,
+                std::vector<std::shared_ptr<Buffer>> buffers,
+                uint32_t groupCountX,
+                uint32_t groupCountY=1,
+                uint32_t groupCountZ=1,
+                std::vector<uint32_t> pushConstantSizes = {}
+            );
+
+            std::vector<std::shared_ptr<PipelineStep>> build();
+
+        private:
+            struct StepDesc {
+                std::string shaderPath; // file to read, or just a name when code is given
+                std::vector<uint32_t> code;
+                std::vector<std::shared_ptr<Buffer>> buffers;
+                uint32_t groupCountX;
+                uint32_t groupCountY;
+                uint32_t groupCountZ;
+                std::vector<uint32_t> pushConstantSizes;
+            };
+
+            std::shared_ptr<VulkanContext> contextPtr;
+            std::vector<StepDesc> steps;
+    };
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <mynydd/mynydd.hpp>
+
+
+namespace mynydd {
+
+    /**
+    * Where the converted members sit in an array of structs. Members all have the same
+    * size, 4, 8 or 16 bytes, e.g. the x, y and z doubles of a dvec3 padded to 32 bytes:
+    * AosLayout{32, 8, {0, 8, 16}}. Offsets and the stride must be multiples of 4.
+    */
+    struct AosLayout {
+        uint32_t recordStrideBytes;
+        uint32_t elementBytes;
+        std::vector<uint32_t> componentOffsets; // bytes from the start of a record
+
+        // n members of elementBytes packed from the start of each record
+        static AosLayout packed(uint32_t recordStrideBytes, uint32_t elementBytes, uint32_t n);
+    };
+
+    struct LayoutParams {
+        static constexpr uint32_t maxComponents = 8;
+
+        uint32_t count;
+        uint32_t recordWords;
+        uint32_t elementWords;
+        uint32_t componentCount;
+        uint32_t soaPitchWords;
+        uint32_t tileRecords;
+        uint32_t toAos;
+        uint32_t pad;
+        uint32_t componentOffsetWords[maxComponents];
+    };
+
+    /**
+    * Converts count records between an AoS buffer and SoA arrays, in either direction.
+    *
+    * The SoA side is one buffer holding each member's array in turn, soaPitchBytes
+    * apart (count * elementBytes by default); splitBuffer gives per-member views of it.
+    * Conversion is a shared-memory tiled transpose, so both directions run at close to
+    * memory bandwidth. Members not listed in the layout are left untouched in the AoS
+    * buffer when converting back.
+    */
+    class LayoutTransformPipeline {
+        public:
+            LayoutTransformPipeline(
+                std::shared_ptr<VulkanContext> contextPtr,
+                std::shared_ptr<Buffer> aosBuffer,
+                std::shared_ptr<Buffer> soaBuffer,
+                uint32_t count,
+                const AosLayout& layout,
+                uint64_t soaPitchBytes = 0
+            );
+
+            void toSoa();
+            void toAos();
+
+            // For recording into a larger batch
+            std::shared_ptr<PipelineStep> getToSoaStep() const { return toSoaStep; }
+            std::shared_ptr<PipelineStep> getToAosStep() const { return toAosStep; }
+
+            uint64_t getSoaPitchBytes() const { return uint64_t(params.soaPitchWords) * 4; }
+
+        private:
+            std::shared_ptr<VulkanContext> contextPtr;
+            LayoutParams params;
+            std::shared_ptr<PipelineStep> toSoaStep;
+            std::shared_ptr<PipelineStep> toAosStep;
+    };
+
+}
@@ -2,16 +2,20 @@
 #define PARTICLE_INDEX_HPP
 
 
+#include <algorithm>
 #include <assert.h>
 #include <cstdint>
 #include <cstring>
 #include <glm/fwd.hpp>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
+#include <mynydd/embedded_shaders.hpp>
 #include <mynydd/mynydd.hpp>
+#include <mynydd/pipeline_builder.hpp>
 #include <mynydd/pipelines/radix_sort.hpp>
 
 namespace mynydd {
@@ -50,7 +54,9 @@ namespace mynydd {
                 nBitsPerAxis(nBitsPerAxis),
                 inputBuffer(inputBuffer),
                 nDataPoints(nDataPoints),
-                m_radixSortPipeline(contextPtr, itemsPerGroup, static_cast<uint32_t>(nDataPoints))
+                m_radixSortPipeline(
+                    contextPtr, itemsPerGroup, static_cast<uint32_t>(nDataPoints), 3 * nBitsPerAxis
+                )
             {
 
                 bool isPow2 = (nDataPoints & (nDataPoints - 1)) != 0 || nDataPoints == 0;
@@ -60,33 +66,63 @@ namespace mynydd {
                 
                 // assert (inputBuffer->getSize() == nDataPoints * sizeof(T) &&
                 //     "Input buffer size must match number of data points times size of T");
-                // TODO: FOR SOME REASON THE WORKGROUP SIZE IS 64 HERE; FIX
 
-                mortonUniformBuffer = std::make_shared<mynydd::Buffer>(
-                    contextPtr, sizeof(MortonParams), true);
+                mortonUniformBuffer = mynydd::getUniformRing(contextPtr)->getBuffer();
 
-                mortonStep = std::make_shared<mynydd::PipelineStep>(
-                    contextPtr, "shaders/morton_u32_3d.comp.spv",
-                    std::vector<std::shared_ptr<mynydd::Buffer>>{
-                        inputBuffer, m_radixSortPipeline.m_ioBufferA, mortonUniformBuffer
-                    },
-                    (nDataPoints + 63) / 64
-                );
                 m_outputIndexCellRangeBuffer = std::make_shared<mynydd::Buffer>(
                     contextPtr, getNCells() * sizeof(mynydd::CellInfo), false);
                 m_outputFlatIndexCellRangeBuffer = std::make_shared<mynydd::Buffer>(
                     contextPtr, getNCells() * sizeof(mynydd::CellInfo), false);
 
-                sortedKeys2IndexStep = std::make_shared<mynydd::PipelineStep>(
-                    contextPtr, "shaders/build_index_from_sorted_keys.comp.spv",
+                // Positions can outgrow maxStorageBufferRange well before the keys do, so
+                // the Morton kernel runs once per chunk, each binding views of the
+                // positions and keys that start at the chunk
+                uint64_t chunkElements = mynydd::maxElementsPerBinding(contextPtr, {sizeof(T), sizeof(uint32_t)});
+                std::vector<std::vector<std::shared_ptr<mynydd::Buffer>>> mortonBindings;
+                if (nDataPoints <= chunkElements) {
+                    mortonChunkSizes = {nDataPoints};
+                    mortonBindings.push_back({inputBuffer, m_radixSortPipeline.m_ioBufferA, mortonUniformBuffer});
+                } else {
+                    for (uint64_t begin = 0; begin < nDataPoints; begin += chunkElements) {
+                        uint64_t count = std::min<uint64_t>(chunkElements, nDataPoints - begin);
+                        mortonChunkSizes.push_back(static_cast<uint32_t>(count));
+                        mortonBindings.push_back({
+                            std::make_shared<mynydd::Buffer>(inputBuffer, begin * sizeof(T), count * sizeof(T)),
+                            std::make_shared<mynydd::Buffer>(
+                                m_radixSortPipeline.m_ioBufferA, begin * sizeof(uint32_t), count * sizeof(uint32_t)
+                            ),
+                            mortonUniformBuffer
+                        });
+                    }
+                }
+
+                mynydd::PipelineBuilder builder(contextPtr);
+                std::vector<size_t> mortonIdx;
+                for (const auto& bindings : mortonBindings) {
+                    mortonIdx.push_back(builder.add(
+                        mynydd::getEmbeddedShader("morton_u32_3d.comp"), "morton_u32_3d.comp",
+                        bindings,
+                        1 // sized from the shader workgroup size below
+                    ));
+                }
+                size_t sortedKeys2IndexIdx = builder.add(
+                    mynydd::getEmbeddedShader("build_index_from_sorted_keys.comp"), "build_index_from_sorted_keys.comp",
                     std::vector<std::shared_ptr<mynydd::Buffer>>{
                         m_radixSortPipeline.getSortedMortonKeysBuffer(), 
                         m_outputIndexCellRangeBuffer,
                         m_outputFlatIndexCellRangeBuffer,
                         mortonUniformBuffer
                     },
-                    (nDataPoints + 63) / 64
+                    1 // sized from the shader workgroup size below
                 );
+                auto steps = builder.build();
+                for (size_t c = 0; c < mortonIdx.size(); ++c) {
+                    mortonSteps.push_back(steps[mortonIdx[c]]);
+                    // The two kernels have different workgroup sizes; size from reflection
+                    mortonSteps.back()->dispatchForElements(mortonChunkSizes[c]);
+                }
+                sortedKeys2IndexStep = steps[sortedKeys2IndexIdx];
+                sortedKeys2IndexStep->dispatchForElements(nDataPoints);
 
                 std::cerr << "ParticleIndexPipeline created with " 
                           << nDataPoints << " data points." << std::endl;
@@ -109,46 +145,27 @@ namespace mynydd {
                     domainMax
                 };
 
-                mynydd::uploadUniformData<MortonParams>(contextPtr, mortonParams, mortonUniformBuffer);
-
-                mynydd::executeBatch(contextPtr, {mortonStep});
-
-                m_radixSortPipeline.execute();
-                // the index needs to be zeroed every time
+                sortedKeys2IndexStep->pushUniformData(mortonParams);
+                for (size_t c = 0; c < mortonSteps.size(); ++c) {
+                    mortonParams.nParticles = mortonChunkSizes[c];
+                    mortonSteps[c]->pushUniformData(mortonParams);
+                }
 
+                // Keys, sort and index are recorded into one command buffer and submitted once
                 VkCommandBufferBeginInfo beginInfo{};
                 beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
                 if (vkBeginCommandBuffer(contextPtr->commandBuffer, &beginInfo) != VK_SUCCESS) {
                     throw std::runtime_error("Failed to begin command buffer for batch execution.");
                 }
 
-                vkCmdFillBuffer(
-                    contextPtr->commandBuffer,
-                    m_outputIndexCellRangeBuffer->getBuffer(),
-                    0,
-                    VK_WHOLE_SIZE,
-                    0
-                );
+                for (const auto& step : mortonSteps) {
+                    mynydd::recordCommandBuffer(contextPtr->commandBuffer, step, true);
+                }
 
-                VkBufferMemoryBarrier barrier{};
-                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;        // writes from vkCmdFillBuffer
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT; // compute shader reads/writes
-                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                barrier.buffer = m_outputIndexCellRangeBuffer->getBuffer();
-                barrier.offset = 0;
-                barrier.size = VK_WHOLE_SIZE;
-
-                vkCmdPipelineBarrier(
-                    contextPtr->commandBuffer,
-                    VK_PIPELINE_STAGE_TRANSFER_BIT,           // after the fill
-                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,     // before compute
-                    0,
-                    0, nullptr,
-                    1, &barrier,
-                    0, nullptr
-                );
+                m_radixSortPipeline.record(contextPtr->commandBuffer);
+
+                // the index needs to be zeroed every time
+                mynydd::recordFillBuffer(contextPtr->commandBuffer, contextPtr, m_outputIndexCellRangeBuffer);
 
                 mynydd::executeBatch(contextPtr, {sortedKeys2IndexStep}, false);
 
@@ -240,7 +257,8 @@ namespace mynydd {
             std::shared_ptr<mynydd::Buffer> indexUniformBuffer;
             std::shared_ptr<mynydd::Buffer> mortonOutputBuffer;
             std::shared_ptr<VulkanContext> contextPtr;
-            std::shared_ptr<PipelineStep> mortonStep;
+            std::vector<std::shared_ptr<PipelineStep>> mortonSteps; // one per chunk of the input
+            std::vector<uint32_t> mortonChunkSizes;
             std::shared_ptr<PipelineStep> sortedKeys2IndexStep;
             std::shared_ptr<mynydd::Buffer> radixUniform;
     };
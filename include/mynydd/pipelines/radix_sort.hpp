@@ -1,13 +1,17 @@
 #pragma once
 
+#include <array>
 #include <assert.h>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <utility>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
 #include <mynydd/mynydd.hpp>
+#include <mynydd/pipelines/scan.hpp>
 
 
 namespace mynydd {
@@ -17,6 +21,7 @@ namespace mynydd {
         uint32_t numBins;
         uint32_t totalSize;
         uint32_t itemsPerGroup;
+        uint32_t keyWords;
     };
 
     struct SumParams {
@@ -35,69 +40,170 @@ namespace mynydd {
         uint totalSize;
         uint workgroupSize;
         uint groupCount;
+        uint payloadWords;
+        uint keyWords;
+    };
+
+    struct UpfrontHistogramParams {
+        uint32_t totalSize;
+        uint32_t nPasses;
+        uint32_t keyWords;
+    };
+
+    struct OnesweepParams {
+        uint32_t bitOffset;
+        uint32_t pass;
+        uint32_t totalSize;
+        uint32_t tileCount;
+        uint32_t payloadWords;
+        uint32_t keyWords;
+    };
+
+    enum class RadixSortBackend {
+        // Four dispatches per pass: histogram, per-workgroup offsets and digit totals,
+        // global digit scan (a ScanPipeline) and scatter
+        MultiPass,
+        // Digit histograms for every pass in one upfront dispatch, then one scatter per
+        // pass that finds its offsets by chained scan with decoupled look-back
+        Onesweep
+    };
+
+    // What moves with the keys through the passes
+    enum class RadixSortPayload {
+        KeysOnly, // nothing, the cheapest when only the sorted keys are needed
+        Index,    // the original position of each key, filled in by the sort
+        Values    // payloadBytes of caller data per key, uploaded to getPayloadInputBuffer()
+    };
+
+    struct RadixSortOptions {
+        uint32_t keyBits = 32;
+        RadixSortBackend backend = RadixSortBackend::MultiPass;
+        RadixSortPayload payload = RadixSortPayload::Index;
+        uint32_t payloadBytes = 4; // Values only: 4, 8, 16 or 32
+        // 4, or 8 for keys of two words, low word first, such as 64-bit Morton codes;
+        // raise keyBits up to 64 to sort on the high word too
+        uint32_t keyBytes = 4;
+        // Digit width: 4, 6, 8 or 11 bits. Wider digits take fewer passes over more bins
+        // (11 bits sort 32-bit keys in three); the onesweep backend takes 8 only.
+        uint32_t bitsPerPass = 8;
     };
 
     struct VulkanContext;
+    class PipelineBuilder;
     
     class RadixSortPipeline {
         public:
+            /**
+            * Sorts totalSize 4- or 8-byte keys (see RadixSortOptions::keyBytes). Only the
+            * low keyBits bits are sorted on, so keys known to fit in fewer bits, e.g. Morton
+            * codes of 3 * nBitsPerAxis bits, take ceil(keyBits / bitsPerPass) passes instead
+            * of 32 * keyWords / bitsPerPass. Higher bits must be zero.
+            */
             RadixSortPipeline(
                 std::shared_ptr<VulkanContext> contextPtr, 
                 uint32_t itemsPerGroup, 
-                uint32_t totalSize
+                uint32_t totalSize,
+                uint32_t keyBits = 32
+            );
+            /**
+            * As above, with the backend, payload, key size and digit width chosen too.
+            * itemsPerGroup is the tile of keys per workgroup: a multiple of 256 up to 4096,
+            * so each invocation handles 1 to 16 keys. Larger tiles mean fewer workgroups,
+            * smaller histogram matrices and less scan work per pass. Onesweep needs 256.
+            */
+            RadixSortPipeline(
+                std::shared_ptr<VulkanContext> contextPtr, 
+                uint32_t itemsPerGroup, 
+                uint32_t totalSize,
+                const RadixSortOptions& options
             );
 
+            // Records the whole sort and submits it once, waiting for the result
             void execute();
+
+            /**
+            * Records the index initialisation and every pass into cmd, which must already
+            * be recording. Nothing is submitted; once the GPU has finished, the caller
+            * releases the context uniform ring (submitAndWait does both).
+            */
+            void record(VkCommandBuffer cmd);
+
+            // Single steps of the multi-pass backend, submitted separately
             void execute_pass(size_t pass);
             void execute_init();
             std::shared_ptr<mynydd::Buffer> getSortedMortonKeysBuffer() {
                 return (nPasses % 2 == 0) ? m_ioBufferA : m_ioBufferB;
             }
+            // Sorted payload: indices or values; null for key-only sorts
             std::shared_ptr<mynydd::Buffer> getSortedIndicesBuffer() {
+                if (payload == RadixSortPayload::KeysOnly) {
+                    return nullptr;
+                }
                 return (nPasses % 2 == 0) ? m_ioSortedIndicesB : m_ioSortedIndicesA;
             }
+            std::shared_ptr<mynydd::Buffer> getSortedPayloadBuffer() {
+                return getSortedIndicesBuffer();
+            }
+            // Where Values payloads go before the sort, next to the keys in m_ioBufferA
+            std::shared_ptr<mynydd::Buffer> getPayloadInputBuffer() {
+                return payload == RadixSortPayload::KeysOnly ? nullptr : m_ioSortedIndicesB;
+            }
 
             // TODO: getters
-            uint32_t itemsPerGroup = 256; // Hardcoded temporarily
+            uint32_t itemsPerGroup = 256;
             uint32_t bitsPerPass = 8;
             uint32_t groupCount;
             uint32_t numBins;
             uint32_t nPasses;
+            uint32_t keyBits;
+            uint32_t keyWords;
+            RadixSortBackend backend;
+            RadixSortPayload payload;
+            uint32_t payloadWords;
             uint32_t nInputElements;
 
             // TODO: don't necessarily need this to be shared ptr
+            // Key ping-pong buffers of keyWords words per key; keys are uploaded to A
             std::shared_ptr<mynydd::Buffer> m_ioBufferA;
             std::shared_ptr<mynydd::Buffer> m_ioBufferB;
+            // Payload ping-pong buffers, named for the default index payload
             std::shared_ptr<mynydd::Buffer> m_ioSortedIndicesA;
             std::shared_ptr<mynydd::Buffer> m_ioSortedIndicesB;
             std::shared_ptr<mynydd::Buffer> perWorkgroupHistograms;
             std::shared_ptr<mynydd::Buffer> globalHistogram;
             std::shared_ptr<mynydd::Buffer> globalPrefixSum;
-            std::shared_ptr<mynydd::Buffer> transposedHistograms;
             std::shared_ptr<mynydd::Buffer> workgroupPrefixSums;
 
+            // Onesweep backend only
+            std::shared_ptr<mynydd::Buffer> digitHistograms;
+            std::shared_ptr<mynydd::Buffer> tileStatus;
+            std::shared_ptr<mynydd::Buffer> tileCounters;
+
 
             ~RadixSortPipeline() {}; // member variables are RAII
             
         private:
-            std::shared_ptr<VulkanContext> contextPtr;
+            // Builder indices of the steps a backend adds, and the members they go to
+            using StepSlots = std::vector<std::pair<size_t, std::shared_ptr<mynydd::PipelineStep>*>>;
+            StepSlots addMultiPassSteps(mynydd::PipelineBuilder& builder, const std::array<uint32_t, 3>& tileGroups);
+            StepSlots addOnesweepSteps(mynydd::PipelineBuilder& builder, const std::array<uint32_t, 3>& tileGroups);
+            void recordOnesweep(VkCommandBuffer cmd);
+
+            // Pushes the pass parameters and returns its steps in dispatch order
+            std::vector<std::shared_ptr<mynydd::PipelineStep>> preparePass(size_t pass);
 
-            std::shared_ptr<mynydd::Buffer> radixUniform;
-            std::shared_ptr<mynydd::Buffer> sumUniform;
-            std::shared_ptr<mynydd::Buffer> workgroupPrefixUniform;
-            std::shared_ptr<mynydd::Buffer> globalPrefixUniform;
-            std::shared_ptr<mynydd::Buffer> transposeUniform;
-            std::shared_ptr<mynydd::Buffer> sortUniform;
+            std::shared_ptr<VulkanContext> contextPtr;
 
             std::shared_ptr<mynydd::PipelineStep> initRangePipeline;
             std::shared_ptr<mynydd::PipelineStep> histPipeline;
             std::shared_ptr<mynydd::PipelineStep> histPipelinePong;
-            std::shared_ptr<mynydd::PipelineStep> sumPipeline;
-            std::shared_ptr<mynydd::PipelineStep> transposePipeline;
-            std::shared_ptr<mynydd::PipelineStep> workgroupPrefixPipeline;
+            std::shared_ptr<mynydd::PipelineStep> histogramScanPipeline;
             std::shared_ptr<mynydd::PipelineStep> sortPipeline;
             std::shared_ptr<mynydd::PipelineStep> sortPipelinePong;
-            std::shared_ptr<mynydd::PipelineStep> globalPrefixPipeline;
+            std::unique_ptr<mynydd::ScanPipeline> globalPrefixScan;
+            std::shared_ptr<mynydd::PipelineStep> upfrontHistogramPipeline;
+            std::shared_ptr<mynydd::PipelineStep> onesweepPipeline;
+            std::shared_ptr<mynydd::PipelineStep> onesweepPipelinePong;
 
 
     };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include <mynydd/mynydd.hpp>
+
+
+namespace mynydd {
+
+    enum class ScanElementType : uint32_t {
+        Uint32 = 0,
+        Uint64 = 1,
+        Float32 = 2
+    };
+
+    enum class ScanOp : uint32_t {
+        Add = 0,
+        Max = 1
+    };
+
+    struct ScanOptions {
+        ScanElementType type = ScanElementType::Uint32;
+        ScanOp op = ScanOp::Add;
+        bool inclusive = false;
+    };
+
+    // Push constants of scan_reduce.comp and scan_tiles.comp
+    struct ScanParams {
+        uint32_t count;
+        uint32_t elementType;
+        uint32_t op;
+        uint32_t inclusive;
+        uint32_t hasCarries;
+    };
+
+    /**
+    * Prefix scan of count elements of input into output, of any length.
+    *
+    * Arrays longer than one 1024-element tile are scanned in levels: tiles are reduced
+    * to one value each, the array of tile sums is scanned the same way, and the scanned
+    * sums are added back as each level's tiles are scanned. Steps are built once for
+    * the given buffers and count; output may be the same buffer as input. Float sums are
+    * associated in tile order, so they can differ from a serial sum in the last bits.
+    */
+    class ScanPipeline {
+        public:
+            ScanPipeline(
+                std::shared_ptr<VulkanContext> contextPtr,
+                std::shared_ptr<Buffer> input,
+                std::shared_ptr<Buffer> output,
+                uint32_t count,
+                const ScanOptions& options = {}
+            );
+
+            void execute();
+
+            // Records every level into cmd, which must already be recording
+            void record(VkCommandBuffer cmd);
+
+            // In dispatch order, for recording into a larger batch
+            const std::vector<std::shared_ptr<PipelineStep>>& getSteps() const { return steps; }
+
+            static uint32_t elementBytes(ScanElementType type) {
+                return type == ScanElementType::Uint64 ? 8 : 4;
+            }
+
+        private:
+            std::shared_ptr<VulkanContext> contextPtr;
+            std::vector<std::shared_ptr<Buffer>> partials; // tile sums of each level above the input
+            std::vector<std::shared_ptr<PipelineStep>> steps;
+    };
+
+}
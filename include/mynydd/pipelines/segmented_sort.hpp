@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/pipelines/radix_sort.hpp>
+
+
+namespace mynydd {
+
+    // Push constants of segmented_sort_local.comp
+    struct SegmentedSortParams {
+        uint32_t nSegments;
+    };
+
+    // Push constants of segmented_sort_pack.comp and segmented_sort_unpack.comp
+    struct SegmentGatherParams {
+        uint32_t count;
+        uint32_t nLong;
+    };
+
+    /**
+    * Sorts many independent segments of one flat array of 32-bit keys, all in one
+    * submission, with the input position of every key alongside.
+    *
+    * segmentOffsets holds nSegments + 1 non-decreasing entries: segment s is keys
+    * [segmentOffsets[s], segmentOffsets[s + 1]), and the last entry is the key count.
+    * Segments of up to localSortCapacity keys are sorted by one workgroup each in
+    * shared memory. Longer ones are gathered into 8-byte keys with their segment in
+    * the high word and sorted together by a single RadixSortPipeline. Both paths give
+    * the order of a stable sort.
+    */
+    class SegmentedSortPipeline {
+        public:
+            SegmentedSortPipeline(
+                std::shared_ptr<VulkanContext> contextPtr,
+                std::shared_ptr<Buffer> keys,
+                const std::vector<uint32_t>& segmentOffsets
+            );
+
+            void execute();
+
+            // Records every dispatch into cmd, which must already be recording
+            void record(VkCommandBuffer cmd);
+
+            std::shared_ptr<Buffer> getSortedKeysBuffer() const { return sortedKeys; }
+            // Input position of each sorted key
+            std::shared_ptr<Buffer> getSortedIndicesBuffer() const { return sortedIndices; }
+
+            // Segments too long for the shared memory sort
+            uint32_t getLongSegmentCount() const { return nLong; }
+
+            // Must match LOCAL_SORT_CAPACITY in segmented_sort_local.comp
+            static const uint32_t localSortCapacity = 1024;
+
+        private:
+            std::shared_ptr<VulkanContext> contextPtr;
+            uint32_t nSegments;
+            uint32_t nLong = 0;
+            uint32_t nLongKeys = 0;
+
+            std::shared_ptr<Buffer> segmentOffsetsBuffer;
+            std::shared_ptr<Buffer> sortedKeys;
+            std::shared_ptr<Buffer> sortedIndices;
+            std::shared_ptr<PipelineStep> localSortStep;
+
+            // Long segments only
+            std::shared_ptr<Buffer> packedStarts;
+            std::shared_ptr<Buffer> longSegmentOffsets;
+            std::unique_ptr<RadixSortPipeline> longSort;
+            std::shared_ptr<PipelineStep> packStep;
+            std::shared_ptr<PipelineStep> unpackStep;
+    };
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace mynydd {
+
+    struct VulkanContext;
+    class PipelineStep;
+    class Tracer;
+
+    /**
+    * Memory traffic and arithmetic of one dispatch of a step. Either declared with
+    * PipelineStep::setWorkloadModel or estimated from the bound buffers, see
+    * PipelineStep::estimateWorkloadModel.
+    */
+    struct WorkloadModel {
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t ops = 0; // arithmetic operations; an FMA counts as two
+
+        uint64_t bytesMoved() const { return bytesRead + bytesWritten; }
+        // Operations per byte moved
+        double intensity() const {
+            return bytesMoved() == 0 ? 0.0 : static_cast<double>(ops) / static_cast<double>(bytesMoved());
+        }
+    };
+
+    // A peak of 0 means it is unavailable: its probe ran too briefly to be timed
+    struct DevicePeaks {
+        double bandwidthGBs = 0.0;
+        double gflops = 0.0;
+
+        // Intensity above which a kernel can be compute bound rather than memory bound;
+        // 0 when either peak is unavailable
+        double ridgeIntensity() const {
+            return bandwidthGBs > 0.0 && gflops > 0.0 ? gflops / bandwidthGBs : 0.0;
+        }
+    };
+
+    /**
+    * Measures achievable bandwidth with a streaming copy and achievable arithmetic
+    * throughput with a chain of FMAs, using the embedded probe shaders. Bandwidth is
+    * that of the host-visible memory every Buffer lives in, which is what library
+    * kernels actually see. GPU timestamps are used where the queue supports them.
+    * A probe whose runs all time at zero leaves its peak at 0 rather than reporting
+    * an infinite rate. The same probe kernels back mynydd_devbench's copy and FMA runs.
+    */
+    DevicePeaks measureDevicePeaks(std::shared_ptr<VulkanContext> contextPtr, uint64_t probeBytes = 64ull << 20);
+
+    struct RooflineEntry {
+        std::string name;
+        WorkloadModel model;
+        uint32_t dispatches = 0; // GPU ranges found for this step in the trace
+        double meanSeconds = 0.0;
+        double achievedGBs = 0.0;
+        double achievedGFlops = 0.0;
+        double bandwidthFraction = 0.0; // of the measured peak; 0 if that peak is unavailable
+        double computeFraction = 0.0;
+        bool memoryBound = true; // intensity below the device ridge point, when it is known
+    };
+
+    /**
+    * Combines each step's workload model with its GPU time ranges in the trace. Steps
+    * are matched to ranges by name, so steps sharing a shader are reported together
+    * under the model of the first of them. Steps with no timed dispatch are skipped.
+    */
+    std::vector<RooflineEntry> buildRooflineReport(
+        const Tracer& tracer,
+        const std::vector<std::shared_ptr<PipelineStep>>& steps,
+        const DevicePeaks& peaks
+    );
+
+    void printRooflineReport(std::ostream& os, const std::vector<RooflineEntry>& entries, const DevicePeaks& peaks);
+
+}
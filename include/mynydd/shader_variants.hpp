@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace mynydd {
+
+    // Preprocessor definitions for one variant, as (name, value) pairs
+    using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+    * Content hash identifying a shader variant: FNV-1a over the GLSL source, the text of
+    * every file it #includes, and the defines. Define order does not matter.
+    */
+    std::string shaderVariantKey(
+        const std::string& sourcePath,
+        const ShaderDefines& defines,
+        const std::vector<std::string>& includeDirs = {}
+    );
+
+    // Where compileShaderVariant stores or looks up the SPIR-V for a variant
+    std::string shaderVariantCachePath(
+        const std::string& sourcePath,
+        const ShaderDefines& defines,
+        const std::string& cacheDir,
+        const std::vector<std::string>& includeDirs = {}
+    );
+
+    // True if the library was built with MYNYDD_WITH_SHADERC
+    bool shaderCompilerAvailable();
+
+    /**
+    * Compiles a GLSL compute shader with the given defines, or loads it from the on-disk
+    * cache if this exact variant was compiled before. Includes are resolved relative to
+    * the including file, then in includeDirs.
+    *
+    * Without shaderc only cached variants can be loaded; a cache miss throws.
+    */
+    std::vector<uint32_t> compileShaderVariant(
+        const std::string& sourcePath,
+        const ShaderDefines& defines,
+        const std::string& cacheDir = "shader_cache",
+        const std::vector<std::string>& includeDirs = {}
+    );
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include <mynydd/memory.hpp>
+
+
+namespace mynydd {
+
+    struct ReflectedBinding {
+        uint32_t set = 0;
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        uint32_t descriptorCount = 1;
+        bool readOnly = false;  // every member is NonWritable
+        bool writeOnly = false; // every member is NonReadable
+    };
+
+    /**
+    * Interface of a compute shader, read from its SPIR-V.
+    *
+    * Only what this library binds is reflected: uniform and storage buffer blocks, the
+    * push-constant block and the workgroup size.
+    */
+    struct ShaderReflection {
+        std::vector<ReflectedBinding> bindings; // sorted by set, then binding
+        uint32_t pushConstantSize = 0;
+        std::array<uint32_t, 3> localSize = {1, 1, 1};
+        // Buffers accessed through device addresses are opaque to reflection
+        bool usesBufferDeviceAddress = false;
+
+        // True if the shader may write to any memory it can reach
+        bool writesMemory() const {
+            if (usesBufferDeviceAddress) {
+                return true;
+            }
+            for (const auto& b : bindings) {
+                if (b.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && !b.readOnly) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    ShaderReflection reflectSpirv(const std::vector<uint32_t>& code);
+
+    /**
+    * Checks that buffers bound positionally to set 0 and the declared push-constant
+    * ranges match what the shader expects. Throws std::runtime_error naming the shader
+    * and binding on a mismatch.
+    */
+    void validateShaderInterface(
+        const ShaderReflection& reflection,
+        const std::vector<std::shared_ptr<Buffer>>& buffers,
+        const std::vector<uint32_t>& pushConstantSizes,
+        const std::string& shaderName
+    );
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+
+namespace mynydd {
+
+    struct VulkanContext;
+
+    /**
+    * Records host scopes and per-step GPU time ranges on one timeline, for export as
+    * Chrome trace JSON (chrome://tracing, Perfetto).
+    *
+    * Tracing is off unless enableTracing() has installed a tracer on the context. GPU
+    * ranges come from a timestamp query pool; timestamps are mapped onto the host
+    * steady clock using an offset calibrated once at construction, so host and GPU
+    * events are comparable to within the latency of one empty submission.
+    */
+    class Tracer {
+        public:
+            struct Event {
+                std::string name;
+                std::string category; // "host" or "gpu"
+                int64_t beginNs;
+                int64_t endNs;
+                uint32_t track; // 0 is the GPU; host threads get 1, 2, ...
+            };
+
+            Tracer(
+                VkPhysicalDevice physicalDevice,
+                VkDevice device,
+                VkQueue queue,
+                uint32_t queueFamilyIndex,
+                VkCommandPool commandPool,
+                uint32_t maxGpuRanges = 1024
+            );
+            ~Tracer();
+
+            Tracer(const Tracer&) = delete;
+            Tracer& operator=(const Tracer&) = delete;
+
+            static int64_t nowNs() {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()
+                ).count();
+            }
+
+            void hostEvent(const std::string& name, int64_t beginNs, int64_t endNs);
+
+            // False when the queue has no timestamp support; GPU ranges are then skipped
+            bool gpuTimingSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+            // Record timestamps around one GPU range; returns false if the query pool is full
+            bool beginGpuRange(VkCommandBuffer cmd, const std::string& name);
+            void endGpuRange(VkCommandBuffer cmd);
+
+            // Read back the ranges recorded since the last call; the work must have completed
+            void resolveGpuRanges();
+
+            std::vector<Event> getEvents() const;
+            void clear();
+
+            std::string toChromeTraceJson() const;
+            void writeChromeTrace(const std::string& path) const;
+
+        private:
+            uint32_t hostTrack();
+
+            VkDevice device;
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            uint32_t maxGpuRanges;
+            double timestampPeriodNs = 1.0;
+            uint64_t timestampMask = ~0ull;
+            int64_t gpuOffsetNs = 0; // host ns = ticks * period + offset
+
+            mutable std::mutex mutex;
+            std::vector<Event> events;
+            std::vector<std::string> pendingGpuNames; // one per recorded range, in query order
+            bool gpuRangeOpen = false;
+            std::map<std::thread::id, uint32_t> hostTracks;
+    };
+
+    /**
+    * Times the enclosing scope as a host event. A null tracer makes this a no-op, so
+    * call sites can pass context->tracer.get() unconditionally.
+    */
+    class TraceScope {
+        public:
+            TraceScope(Tracer* tracer, const char* name)
+                : tracer(tracer), name(name), beginNs(tracer ? Tracer::nowNs() : 0) {}
+            ~TraceScope() {
+                if (tracer) {
+                    tracer->hostEvent(name, beginNs, Tracer::nowNs());
+                }
+            }
+            TraceScope(const TraceScope&) = delete;
+            TraceScope& operator=(const TraceScope&) = delete;
+
+        private:
+            Tracer* tracer;
+            const char* name;
+            int64_t beginNs;
+    };
+
+    // Installs a tracer on the context (replacing any existing one) and returns it
+    std::shared_ptr<Tracer> enableTracing(std::shared_ptr<VulkanContext> contextPtr, uint32_t maxGpuRanges = 1024);
+
+}
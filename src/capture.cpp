@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include "../include/mynydd/capture.hpp"
+#include "../include/mynydd/mynydd.hpp"
+
+namespace mynydd {
+
+    namespace {
+
+        const char captureMagic[8] = {'M', 'Y', 'N', 'Y', 'D', 'D', 'C', 'P'};
+        const uint32_t captureVersion = 1;
+
+        class Writer {
+            public:
+                explicit Writer(const std::string& path) : file(path, std::ios::binary | std::ios::trunc), path(path) {
+                    if (!file.is_open()) {
+                        throw std::runtime_error("Failed to open capture file for writing: " + path);
+                    }
+                }
+                void bytes(const void* data, size_t size) {
+                    file.write(static_cast<const char*>(data), size);
+                    if (!file) {
+                        throw std::runtime_error("Failed to write capture file: " + path);
+                    }
+                }
+                void u32(uint32_t v) { bytes(&v, sizeof(v)); }
+                void u64(uint64_t v) { bytes(&v, sizeof(v)); }
+                template<typename T>
+                void vec(const std::vector<T>& v) {
+                    u64(v.size());
+                    bytes(v.data(), v.size() * sizeof(T));
+                }
+                void str(const std::string& s) {
+                    u64(s.size());
+                    bytes(s.data(), s.size());
+                }
+
+            private:
+                std::ofstream file;
+                std::string path;
+        };
+
+        class Reader {
+            public:
+                explicit Reader(const std::string& path) : file(path, std::ios::binary), path(path) {
+                    if (!file.is_open()) {
+                        throw std::runtime_error("Failed to open capture file: " + path);
+                    }
+                }
+                void bytes(void* data, size_t size) {
+                    file.read(static_cast<char*>(data), size);
+                    if (!file) {
+                        throw std::runtime_error("Truncated capture file: " + path);
+                    }
+                }
+                uint32_t u32() { uint32_t v; bytes(&v, sizeof(v)); return v; }
+                uint64_t u64() { uint64_t v; bytes(&v, sizeof(v)); return v; }
+                template<typename T>
+                std::vector<T> vec() {
+                    std::vector<T> v(u64());
+                    bytes(v.data(), v.size() * sizeof(T));
+                    return v;
+                }
+                std::string str() {
+                    std::string s(u64(), '\0');
+                    bytes(s.data(), s.size());
+                    return s;
+                }
+
+            private:
+                std::ifstream file;
+                std::string path;
+        };
+
+        // The uniform ring is persistently mapped and memory may not be mapped twice,
+        // so its contents are copied from the existing mapping
+        std::vector<uint8_t> captureContents(std::shared_ptr<VulkanContext> contextPtr, std::shared_ptr<Buffer> buffer) {
+            const auto& ring = contextPtr->uniformRing;
+            if (ring && ring->getBuffer() == buffer) {
+                const uint8_t* mapped = static_cast<const uint8_t*>(ring->getMappedData());
+                return std::vector<uint8_t>(mapped, mapped + buffer->getSize());
+            }
+            return fetchData<uint8_t>(contextPtr, buffer, buffer->getSize());
+        }
+
+    }
+
+    BatchCapture captureBatch(
+        std::shared_ptr<VulkanContext> contextPtr,
+        const std::vector<std::shared_ptr<PipelineStep>>& steps,
+        bool externalCommands
+    ) {
+        BatchCapture capture;
+        capture.externalCommands = externalCommands;
+        std::map<const Buffer*, uint32_t> bufferIndex;
+
+        for (const auto& step : steps) {
+            if (step->getSpirv().empty()) {
+                throw std::runtime_error("Cannot capture step " + step->getName() + ": its SPIR-V was not kept");
+            }
+            if (step->getReflection().usesBufferDeviceAddress) {
+                throw std::runtime_error(
+                    "Cannot capture step " + step->getName() + ": buffer device addresses do not survive a replay"
+                );
+            }
+
+            CapturedStep captured;
+            captured.name = step->getName();
+            captured.spirv = step->getSpirv();
+            captured.groupCount = {step->groupCountX, step->groupCountY, step->groupCountZ};
+            captured.dynamicOffsets = step->getDynamicOffsets();
+            if (step->hasPushConstantData()) {
+                PushConstantData pcData = step->getPushConstantData();
+                captured.pushConstantOffset = pcData.offset;
+                captured.pushConstants.resize(pcData.size);
+                std::memcpy(captured.pushConstants.data(), pcData.push_data.data(), pcData.size);
+            }
+
+            for (const auto& buffer : step->getBuffers()) {
+                auto it = bufferIndex.find(buffer.get());
+                if (it == bufferIndex.end()) {
+                    it = bufferIndex.emplace(buffer.get(), static_cast<uint32_t>(capture.buffers.size())).first;
+                    capture.buffers.push_back({
+                        buffer->getType(),
+                        buffer->getSize(),
+                        buffer->getRange(),
+                        captureContents(contextPtr, buffer)
+                    });
+                }
+                captured.buffers.push_back(it->second);
+            }
+            capture.steps.push_back(std::move(captured));
+        }
+        return capture;
+    }
+
+    void captureNextBatch(std::shared_ptr<VulkanContext> contextPtr, const std::string& path) {
+        if (path.empty()) {
+            throw std::runtime_error("Capture path must not be empty");
+        }
+        contextPtr->capturePath = path;
+    }
+
+    void writeCapture(const BatchCapture& capture, const std::string& path) {
+        Writer out(path);
+        out.bytes(captureMagic, sizeof(captureMagic));
+        out.u32(captureVersion);
+        out.u32(capture.externalCommands ? 1 : 0);
+
+        out.u64(capture.buffers.size());
+        for (const CapturedBuffer& buffer : capture.buffers) {
+            out.u32(static_cast<uint32_t>(buffer.type));
+            out.u64(buffer.size);
+            out.u64(buffer.range);
+            out.vec(buffer.contents);
+        }
+
+        out.u64(capture.steps.size());
+        for (const CapturedStep& step : capture.steps) {
+            out.str(step.name);
+            out.vec(step.spirv);
+            for (uint32_t count : step.groupCount) {
+                out.u32(count);
+            }
+            out.vec(step.buffers);
+            out.u32(step.pushConstantOffset);
+            out.vec(step.pushConstants);
+            out.vec(step.dynamicOffsets);
+        }
+    }
+
+    BatchCapture readCapture(const std::string& path) {
+        Reader in(path);
+        char magic[sizeof(captureMagic)];
+        in.bytes(magic, sizeof(magic));
+        if (std::memcmp(magic, captureMagic, sizeof(magic)) != 0) {
+            throw std::runtime_error("Not a mynydd capture file: " + path);
+        }
+        uint32_t version = in.u32();
+        if (version != captureVersion) {
+            throw std::runtime_error(
+                "Unsupported capture version " + std::to_string(version) + " in " + path
+            );
+        }
+
+        BatchCapture capture;
+        capture.externalCommands = in.u32() != 0;
+
+        capture.buffers.resize(in.u64());
+        for (CapturedBuffer& buffer : capture.buffers) {
+            buffer.type = static_cast<VkDescriptorType>(in.u32());
+            buffer.size = in.u64();
+            buffer.range = in.u64();
+            buffer.contents = in.vec<uint8_t>();
+        }
+
+        capture.steps.resize(in.u64());
+        for (CapturedStep& step : capture.steps) {
+            step.name = in.str();
+            step.spirv = in.vec<uint32_t>();
+            for (uint32_t& count : step.groupCount) {
+                count = in.u32();
+            }
+            step.buffers = in.vec<uint32_t>();
+            for (uint32_t index : step.buffers) {
+                if (index >= capture.buffers.size()) {
+                    throw std::runtime_error("Step " + step.name + " refers to a missing buffer in " + path);
+                }
+            }
+            step.pushConstantOffset = in.u32();
+            step.pushConstants = in.vec<uint8_t>();
+            step.dynamicOffsets = in.vec<uint32_t>();
+        }
+        return capture;
+    }
+
+    ReplayBatch instantiateCapture(std::shared_ptr<VulkanContext> contextPtr, const BatchCapture& capture) {
+        ReplayBatch replay;
+        for (const CapturedBuffer& captured : capture.buffers) {
+            VkDeviceSize range = captured.range == captured.size ? VK_WHOLE_SIZE : captured.range;
+            replay.buffers.push_back(std::make_shared<Buffer>(contextPtr, captured.size, captured.type, range));
+        }
+        restoreCaptureBuffers(contextPtr, capture, replay);
+
+        for (const CapturedStep& captured : capture.steps) {
+            std::vector<std::shared_ptr<Buffer>> buffers;
+            for (uint32_t index : captured.buffers) {
+                buffers.push_back(replay.buffers[index]);
+            }
+            std::vector<uint32_t> pushConstantSizes;
+            uint32_t pushConstantSize = std::max(
+                static_cast<uint32_t>(captured.pushConstants.size()),
+                reflectSpirv(captured.spirv).pushConstantSize
+            );
+            if (pushConstantSize > 0) {
+                pushConstantSizes.push_back(pushConstantSize);
+            }
+
+            auto step = std::make_shared<PipelineStep>(
+                contextPtr, captured.spirv, captured.name, buffers,
+                captured.groupCount[0], captured.groupCount[1], captured.groupCount[2],
+                pushConstantSizes
+            );
+            if (!captured.pushConstants.empty()) {
+                step->setPushConstantsBytes(
+                    captured.pushConstants.data(),
+                    static_cast<uint32_t>(captured.pushConstants.size()),
+                    captured.pushConstantOffset
+                );
+            }
+            if (!captured.dynamicOffsets.empty()) {
+                step->setDynamicOffsets(captured.dynamicOffsets);
+            }
+            replay.steps.push_back(step);
+        }
+        return replay;
+    }
+
+    void restoreCaptureBuffers(
+        std::shared_ptr<VulkanContext> contextPtr,
+        const BatchCapture& capture,
+        const ReplayBatch& replay
+    ) {
+        for (size_t i = 0; i < capture.buffers.size(); ++i) {
+            if (!capture.buffers[i].contents.empty()) {
+                uploadData<uint8_t>(contextPtr, capture.buffers[i].contents, replay.buffers[i]);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include "../include/mynydd/compute_graph.hpp"
+
+namespace mynydd {
+
+    static bool intersects(const std::vector<const Buffer*>& a, const std::vector<const Buffer*>& b) {
+        // Views of one allocation conflict when their byte ranges overlap
+        for (const Buffer* x : a) {
+            for (const Buffer* y : b) {
+                if (x == y || x->overlaps(*y)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    ComputeGraph::ComputeGraph(std::shared_ptr<VulkanContext> contextPtr) : contextPtr(contextPtr) {
+        if (!contextPtr || contextPtr->device == VK_NULL_HANDLE) {
+            throw std::runtime_error("Invalid Vulkan context for compute graph.");
+        }
+    }
+
+    ComputeGraph::~ComputeGraph() {
+        releaseSegments();
+    }
+
+    size_t ComputeGraph::addNode(
+        std::shared_ptr<PipelineStep> step,
+        const std::vector<std::shared_ptr<Buffer>>& reads,
+        const std::vector<std::shared_ptr<Buffer>>& writes
+    ) {
+        if (!step) {
+            throw std::runtime_error("Null PipelineStep pointer added to compute graph.");
+        }
+
+        Node node;
+        node.step = step;
+        for (const auto& b : reads) {
+            node.reads.push_back(b.get());
+        }
+        for (const auto& b : writes) {
+            node.writes.push_back(b.get());
+        }
+
+        // Hazards against every earlier node: RAW, WAW and WAR
+        for (size_t j = 0; j < nodes.size(); ++j) {
+            const Node& prev = nodes[j];
+            if (
+                intersects(node.reads, prev.writes) ||
+                intersects(node.writes, prev.writes) ||
+                intersects(node.writes, prev.reads)
+            ) {
+                node.deps.push_back(j);
+            }
+        }
+
+        nodes.push_back(std::move(node));
+        if (compiled) {
+            releaseSegments();
+            compiled = false;
+        }
+        return nodes.size() - 1;
+    }
+
+    void ComputeGraph::compile() {
+        // Nodes arrive in a valid serial order, so every dependency points backwards and
+        // insertion order is already a topological order. Greedily extend a chain when one
+        // of the node's dependencies is that chain's current tail; otherwise start a new one.
+        std::vector<size_t> chainTails;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            Node& node = nodes[i];
+            bool placed = false;
+            for (auto it = node.deps.rbegin(); it != node.deps.rend(); ++it) {
+                size_t chain = nodes[*it].chain;
+                if (chainTails[chain] == *it) {
+                    node.chain = chain;
+                    chainTails[chain] = i;
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed) {
+                node.chain = chainTails.size();
+                chainTails.push_back(i);
+            }
+        }
+        chainCount = chainTails.size();
+
+        // A node that feeds another chain must end its segment, so that the semaphore it
+        // signals is not held back by later work on the same chain
+        std::vector<bool> feedsOtherChain(nodes.size(), false);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (size_t d : nodes[i].deps) {
+                if (nodes[d].chain != nodes[i].chain) {
+                    feedsOtherChain[d] = true;
+                }
+            }
+        }
+
+        // Cut chains into segments. A segment only waits on other chains at its start and only
+        // signals them at its end, so ordering segments by their first node is topological.
+        std::vector<size_t> lastInChain(chainCount, SIZE_MAX);
+        std::vector<size_t> segmentOfChainTail(chainCount, SIZE_MAX);
+        std::vector<std::vector<size_t>> segmentNodes;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            Node& node = nodes[i];
+            size_t prev = lastInChain[node.chain];
+            bool waitsOnOtherChain = std::any_of(node.deps.begin(), node.deps.end(), [&](size_t d) {
+                return nodes[d].chain != node.chain;
+            });
+            if (prev == SIZE_MAX || feedsOtherChain[prev] || waitsOnOtherChain) {
+                segmentOfChainTail[node.chain] = segmentNodes.size();
+                segmentNodes.emplace_back();
+            }
+            node.segment = segmentOfChainTail[node.chain];
+            segmentNodes[node.segment].push_back(i);
+            lastInChain[node.chain] = i;
+        }
+
+        const auto& queues = contextPtr->computeQueues;
+        if (queues.empty()) {
+            throw std::runtime_error("Vulkan context has no compute queues.");
+        }
+
+        segments.resize(segmentNodes.size());
+        for (size_t s = 0; s < segments.size(); ++s) {
+            Segment& segment = segments[s];
+            segment.nodes = segmentNodes[s];
+            segment.queue = queues[nodes[segment.nodes.front()].chain % queues.size()];
+            segment.commandBuffer = allocateCommandBuffer(contextPtr->device, contextPtr->commandPool);
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(contextPtr->device, &fenceInfo, nullptr, &segment.fence) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create fence for compute graph.");
+            }
+        }
+
+        // One binary semaphore per segment-to-segment edge; binary semaphores can only be
+        // waited on once per signal
+        std::vector<std::pair<size_t, size_t>> edges;
+        for (const Node& node : nodes) {
+            for (size_t d : node.deps) {
+                std::pair<size_t, size_t> edge{nodes[d].segment, node.segment};
+                if (edge.first != edge.second && std::find(edges.begin(), edges.end(), edge) == edges.end()) {
+                    edges.push_back(edge);
+                }
+            }
+        }
+        for (const auto& edge : edges) {
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            VkSemaphore semaphore;
+            if (vkCreateSemaphore(contextPtr->device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create semaphore for compute graph.");
+            }
+            semaphores.push_back(semaphore);
+            segments[edge.first].signals.push_back(semaphore);
+            segments[edge.second].waits.push_back(semaphore);
+        }
+
+        compiled = true;
+    }
+
+    void ComputeGraph::releaseSegments() {
+        if (!contextPtr || contextPtr->device == VK_NULL_HANDLE) {
+            return;
+        }
+        for (Segment& segment : segments) {
+            if (segment.commandBuffer != VK_NULL_HANDLE) {
+                vkFreeCommandBuffers(contextPtr->device, contextPtr->commandPool, 1, &segment.commandBuffer);
+            }
+            if (segment.fence != VK_NULL_HANDLE) {
+                vkDestroyFence(contextPtr->device, segment.fence, nullptr);
+            }
+        }
+        for (VkSemaphore semaphore : semaphores) {
+            vkDestroySemaphore(contextPtr->device, semaphore, nullptr);
+        }
+        segments.clear();
+        semaphores.clear();
+    }
+
+    void ComputeGraph::execute() {
+        if (nodes.empty()) {
+            throw std::runtime_error("No nodes in compute graph.");
+        }
+        if (!compiled) {
+            compile();
+        }
+
+        Tracer* tracer = contextPtr->tracer.get();
+        std::vector<VkFence> fences;
+        for (Segment& segment : segments) {
+            std::optional<TraceScope> recordScope(std::in_place, tracer, "record");
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            if (vkBeginCommandBuffer(segment.commandBuffer, &beginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to begin command buffer for compute graph.");
+            }
+            for (size_t k = 0; k < segment.nodes.size(); ++k) {
+                recordCommandBuffer(
+                    segment.commandBuffer,
+                    nodes[segment.nodes[k]].step,
+                    k + 1 < segment.nodes.size()
+                );
+            }
+            if (vkEndCommandBuffer(segment.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to end command buffer for compute graph.");
+            }
+            recordScope.reset();
+
+            std::vector<VkPipelineStageFlags> waitStages(
+                segment.waits.size(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+            );
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.waitSemaphoreCount = static_cast<uint32_t>(segment.waits.size());
+            submitInfo.pWaitSemaphores = segment.waits.data();
+            submitInfo.pWaitDstStageMask = waitStages.data();
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &segment.commandBuffer;
+            submitInfo.signalSemaphoreCount = static_cast<uint32_t>(segment.signals.size());
+            submitInfo.pSignalSemaphores = segment.signals.data();
+
+            TraceScope submitScope(tracer, "submit");
+            if (vkQueueSubmit(segment.queue, 1, &submitInfo, segment.fence) != VK_SUCCESS) {
+                // Do not leave earlier submissions running against freed resources
+                if (!fences.empty()) {
+                    vkWaitForFences(contextPtr->device, fences.size(), fences.data(), VK_TRUE, UINT64_MAX);
+                }
+                // Semaphores signalled so far have no waiter any more, so rebuild next time
+                releaseSegments();
+                compiled = false;
+                throw std::runtime_error("Failed to submit compute graph segment.");
+            }
+            RuntimeMetrics::count(contextPtr->metrics->submits);
+            fences.push_back(segment.fence);
+        }
+
+        {
+            TraceScope scope(tracer, "wait");
+            auto waitStart = std::chrono::steady_clock::now();
+            vkWaitForFences(contextPtr->device, fences.size(), fences.data(), VK_TRUE, UINT64_MAX);
+            RuntimeMetrics::count(contextPtr->metrics->fenceWaits);
+            RuntimeMetrics::count(contextPtr->metrics->fenceWaitNs, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - waitStart
+            ).count());
+        }
+        vkResetFences(contextPtr->device, fences.size(), fences.data());
+        if (tracer) {
+            tracer->resolveGpuRanges();
+        }
+
+        if (contextPtr->uniformRing) {
+            contextPtr->uniformRing->release();
+        }
+    }
+
+}
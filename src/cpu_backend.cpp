@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../include/mynydd/cpu_backend.hpp"
+
+namespace mynydd {
+
+    ThreadPool::ThreadPool(unsigned nThreads) {
+        nThreads = std::max(1u, nThreads);
+        for (unsigned w = 1; w < nThreads; ++w) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, w);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t, unsigned)>& body) {
+        if (count == 0) {
+            return;
+        }
+        if (workers.empty() || count == 1) {
+            for (uint32_t i = 0; i < count; ++i) {
+                body(i, 0);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &body;
+            jobCount = count;
+            next.store(0);
+            busy = static_cast<unsigned>(workers.size());
+            error = nullptr;
+            ++generation;
+        }
+        wake.notify_all();
+        runChunks(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    void ThreadPool::workerLoop(unsigned worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            runChunks(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0) {
+                    done.notify_one();
+                }
+            }
+        }
+    }
+
+    void ThreadPool::runChunks(unsigned worker) {
+        // Indices are handed out one at a time; each is a whole workgroup, which is
+        // coarse enough that the atomic is not the bottleneck
+        for (uint32_t i = next.fetch_add(1); i < jobCount; i = next.fetch_add(1)) {
+            try {
+                (*job)(i, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void CpuPipelineStep::execute() {
+        const glm::uvec3 numWorkGroups(groupCountX, groupCountY, groupCountZ);
+        const uint64_t total = uint64_t(groupCountX) * groupCountY * groupCountZ;
+        if (total == 0) {
+            return;
+        }
+        if (total > UINT32_MAX) {
+            throw std::runtime_error("CPU step dispatches more than 2^32 workgroups");
+        }
+
+        ThreadPool& pool = contextPtr->pool;
+        // Sized once up front and never grown, so shared() pointers stay valid
+        std::vector<std::vector<std::byte>> sharedArenas(pool.size(), std::vector<std::byte>(sharedMemorySize));
+        pool.parallelFor(static_cast<uint32_t>(total), [&](uint32_t flat, unsigned worker) {
+            glm::uvec3 workGroupID(
+                flat % groupCountX,
+                (flat / groupCountX) % groupCountY,
+                flat / (groupCountX * groupCountY)
+            );
+            Workgroup group(
+                workGroupID, numWorkGroups, localSize, buffers, pushConstants,
+                sharedArenas[worker].data(), sharedMemorySize
+            );
+            kernel(group);
+        });
+    }
+
+    void executeBatch(
+        std::shared_ptr<CpuContext> contextPtr,
+        const std::vector<std::shared_ptr<CpuPipelineStep>>& steps
+    ) {
+        for (const auto& step : steps) {
+            step->execute();
+        }
+    }
+
+}
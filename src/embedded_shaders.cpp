@@ -0,0 +1,19 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/mynydd/embedded_shaders.hpp"
+
+namespace mynydd {
+
+    std::vector<uint32_t> getEmbeddedShader(const std::string& name) {
+        for (size_t i = 0; i < embeddedShaderCount; ++i) {
+            if (name == embeddedShaders[i].name) {
+                const EmbeddedShader& shader = embeddedShaders[i];
+                return std::vector<uint32_t>(shader.code, shader.code + shader.wordCount);
+            }
+        }
+        throw std::runtime_error("No embedded shader named " + name);
+    }
+
+}
@@ -1,29 +1,148 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "../include/mynydd/mynydd.hpp"
 
 namespace mynydd {
     // TODO: should store pointer to context, not device; in fact device should be private
     Buffer::Buffer(std::shared_ptr<VulkanContext> vkc, size_t size, bool uniform)
-        : device(vkc->device), size(size) 
+        : Buffer(vkc, size, uniform ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+    {}
+
+    Buffer::Buffer(
+        std::shared_ptr<VulkanContext> vkc,
+        size_t size,
+        VkDescriptorType type,
+        VkDeviceSize range
+    ) : device(vkc->device), size(size), type(type), range(range)
     {
+        bool uniform = type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+            || type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 
-        if (uniform) {
-            type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        // Storage buffers are addressable from shaders when the device supports it
+        bool addressable = !uniform && vkc->bufferDeviceAddress;
+
+        VkBufferUsageFlags usage = uniform
+            ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+            : (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        if (addressable) {
+            usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
         }
 
-        VkBuffer newBuffer = createBuffer(
-            device, size,
-            uniform ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT : (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
-        );
+        VkBuffer newBuffer = createBuffer(device, size, usage);
 
         VkDeviceMemory newBufferMemory = allocateAndBindMemory(
-            vkc->physicalDevice, 
+            vkc->physicalDevice,
             device,
             newBuffer,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            addressable ? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR : 0
         );
 
         this->buffer = newBuffer;
         this->memory = newBufferMemory;
+
+        if (addressable) {
+            VkBufferDeviceAddressInfoKHR addressInfo{};
+            addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+            addressInfo.buffer = newBuffer;
+            this->deviceAddress = vkc->getBufferDeviceAddress(device, &addressInfo);
+        }
+    }
+
+    Buffer::Buffer(std::shared_ptr<Buffer> parent, VkDeviceSize offset, VkDeviceSize size)
+        : device(parent->device), buffer(parent->buffer), memory(parent->memory), size(size),
+          type(parent->type), offset(parent->offset + offset), parent(parent)
+    {
+        if (offset + size > parent->size) {
+            throw std::runtime_error(
+                "Buffer view [" + std::to_string(offset) + ", " + std::to_string(offset + size) +
+                ") lies outside its " + std::to_string(parent->size) + " byte parent"
+            );
+        }
+        if (parent->deviceAddress != 0) {
+            deviceAddress = parent->deviceAddress + offset;
+        }
+    }
+
+    uint64_t maxElementsPerBinding(std::shared_ptr<VulkanContext> vkc, const std::vector<size_t>& elementSizes) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(vkc->physicalDevice, &props);
+        uint64_t alignment = std::max<uint64_t>(1, props.limits.minStorageBufferOffsetAlignment);
+        uint64_t elements = UINT64_MAX;
+        uint64_t step = 1; // chunks of a multiple of step elements start aligned in every array
+        for (size_t elementSize : elementSizes) {
+            if (elementSize == 0) {
+                throw std::runtime_error("maxElementsPerBinding needs non-zero element sizes");
+            }
+            elements = std::min<uint64_t>(elements, props.limits.maxStorageBufferRange / elementSize);
+            step = std::lcm(step, alignment / std::gcd(alignment, static_cast<uint64_t>(elementSize)));
+        }
+        elements = elements / step * step;
+        if (elementSizes.empty() || elements == 0) {
+            throw std::runtime_error("Elements cannot be chunked within maxStorageBufferRange");
+        }
+        return elements;
+    }
+
+    std::vector<std::shared_ptr<Buffer>> splitBuffer(
+        std::shared_ptr<Buffer> buffer,
+        size_t elementSize,
+        uint64_t elementsPerChunk
+    ) {
+        if (elementSize == 0 || elementsPerChunk == 0) {
+            throw std::runtime_error("splitBuffer needs a non-zero element size and chunk length");
+        }
+        VkDeviceSize chunkBytes = elementsPerChunk * elementSize;
+        std::vector<std::shared_ptr<Buffer>> chunks;
+        for (VkDeviceSize begin = 0; begin < buffer->getSize(); begin += chunkBytes) {
+            VkDeviceSize bytes = std::min(chunkBytes, buffer->getSize() - begin);
+            chunks.push_back(std::make_shared<Buffer>(buffer, begin, bytes));
+        }
+        return chunks;
+    }
+
+    UniformRing::UniformRing(
+        std::shared_ptr<VulkanContext> vkc,
+        VkDeviceSize blockSize,
+        uint32_t blockCount
+    ) : device(vkc->device), metrics(vkc->metrics), blockCount(blockCount) {
+        if (blockCount == 0) {
+            throw std::runtime_error("Uniform ring requires at least one block");
+        }
+
+        // Dynamic offsets must be multiples of minUniformBufferOffsetAlignment
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(vkc->physicalDevice, &props);
+        VkDeviceSize alignment = props.limits.minUniformBufferOffsetAlignment;
+        if (alignment > 1) {
+            blockSize = ((blockSize + alignment - 1) / alignment) * alignment;
+        }
+        if (blockSize > props.limits.maxUniformBufferRange) {
+            throw std::runtime_error("Uniform ring block size exceeds device maxUniformBufferRange");
+        }
+        this->blockSize = blockSize;
+
+        buffer = std::make_shared<Buffer>(
+            vkc, blockSize * blockCount, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, blockSize
+        );
+
+        // Memory is host coherent, so it stays mapped for the lifetime of the ring
+        RuntimeMetrics::count(vkc->metrics->mapCalls);
+        if (vkMapMemory(device, buffer->getMemory(), 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to map uniform ring memory");
+        }
+    }
+
+    UniformRing::~UniformRing() {
+        if (mapped != nullptr && buffer) {
+            vkUnmapMemory(device, buffer->getMemory());
+        }
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,62 @@
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+#include "../include/mynydd/metrics.hpp"
+
+namespace mynydd {
+
+    RuntimeMetricsSnapshot RuntimeMetricsSnapshot::operator-(const RuntimeMetricsSnapshot& earlier) const {
+        RuntimeMetricsSnapshot delta;
+        delta.submits = submits - earlier.submits;
+        delta.fenceWaits = fenceWaits - earlier.fenceWaits;
+        delta.fenceWaitNs = fenceWaitNs - earlier.fenceWaitNs;
+        delta.barriers = barriers - earlier.barriers;
+        delta.descriptorPoolsCreated = descriptorPoolsCreated - earlier.descriptorPoolsCreated;
+        delta.descriptorSetsAllocated = descriptorSetsAllocated - earlier.descriptorSetsAllocated;
+        delta.bytesUploaded = bytesUploaded - earlier.bytesUploaded;
+        delta.bytesDownloaded = bytesDownloaded - earlier.bytesDownloaded;
+        delta.mapCalls = mapCalls - earlier.mapCalls;
+        delta.unmapCalls = unmapCalls - earlier.unmapCalls;
+        return delta;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const RuntimeMetricsSnapshot& s) {
+        return os
+            << "submits=" << s.submits
+            << " fence_waits=" << s.fenceWaits
+            << " fence_wait_ms=" << static_cast<double>(s.fenceWaitNs) / 1e6
+            << " barriers=" << s.barriers
+            << " descriptor_pools=" << s.descriptorPoolsCreated
+            << " descriptor_sets=" << s.descriptorSetsAllocated
+            << " uploaded_bytes=" << s.bytesUploaded
+            << " downloaded_bytes=" << s.bytesDownloaded
+            << " maps=" << s.mapCalls
+            << " unmaps=" << s.unmapCalls;
+    }
+
+    RuntimeMetricsSnapshot RuntimeMetrics::snapshot() const {
+        RuntimeMetricsSnapshot s;
+        s.submits = submits.load(std::memory_order_relaxed);
+        s.fenceWaits = fenceWaits.load(std::memory_order_relaxed);
+        s.fenceWaitNs = fenceWaitNs.load(std::memory_order_relaxed);
+        s.barriers = barriers.load(std::memory_order_relaxed);
+        s.descriptorPoolsCreated = descriptorPoolsCreated.load(std::memory_order_relaxed);
+        s.descriptorSetsAllocated = descriptorSetsAllocated.load(std::memory_order_relaxed);
+        s.bytesUploaded = bytesUploaded.load(std::memory_order_relaxed);
+        s.bytesDownloaded = bytesDownloaded.load(std::memory_order_relaxed);
+        s.mapCalls = mapCalls.load(std::memory_order_relaxed);
+        s.unmapCalls = unmapCalls.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void RuntimeMetrics::reset() {
+        for (auto* counter : {
+            &submits, &fenceWaits, &fenceWaitNs, &barriers, &descriptorPoolsCreated,
+            &descriptorSetsAllocated, &bytesUploaded, &bytesDownloaded, &mapCalls, &unmapCalls
+        }) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+
+}
@@ -1,15 +1,19 @@
+#include <algorithm>
 #include <array>
 #include <assert.h>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
+#include "../include/mynydd/capture.hpp"
 #include "../include/mynydd/mynydd.hpp"
 using namespace mynydd;
 
@@ -183,17 +187,42 @@ namespace mynydd {
     throw std::runtime_error("No suitable GPU with compute queue found");
     }
 
+    bool hasDeviceExtension(VkPhysicalDevice physicalDevice, const char* name) {
+        uint32_t extCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extCount, nullptr);
+        std::vector<VkExtensionProperties> exts(extCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extCount, exts.data());
+        for (const auto& e : exts) {
+            if (std::strcmp(e.extensionName, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Upper bound on queues taken from the compute family
+    static const uint32_t maxComputeQueues = 4;
+
     VkDevice createLogicalDevice(
         VkPhysicalDevice physicalDevice,
         uint32_t computeQueueFamilyIndex,
-        VkQueue &computeQueue
+        std::vector<VkQueue> &computeQueues,
+        bool &bufferDeviceAddress
     ) {
-        float queuePriority = 1.0f;
+        // Take several queues from the compute family when available, so that independent
+        // work (see ComputeGraph) can be submitted concurrently
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+        uint32_t queueCount = std::min(queueFamilies[computeQueueFamilyIndex].queueCount, maxComputeQueues);
+
+        std::vector<float> queuePriorities(queueCount, 1.0f);
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = computeQueueFamilyIndex;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.queueCount = queueCount;
+        queueCreateInfo.pQueuePriorities = queuePriorities.data();
 
         VkDeviceCreateInfo deviceCreateInfo{};
         deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -205,6 +234,29 @@ namespace mynydd {
 
         deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
+        // Buffer device addresses are optional; they enable bindless access to buffers
+        // through pointers passed in push constants
+        std::vector<const char*> enabledExtensions;
+        VkPhysicalDeviceBufferDeviceAddressFeaturesKHR bdaFeatures{};
+        bdaFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+        bufferDeviceAddress = false;
+        if (hasDeviceExtension(physicalDevice, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)) {
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &bdaFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+            if (bdaFeatures.bufferDeviceAddress == VK_TRUE) {
+                bdaFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+                bdaFeatures.bufferDeviceAddressMultiDevice = VK_FALSE;
+                bdaFeatures.pNext = nullptr;
+                enabledExtensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+                deviceCreateInfo.pNext = &bdaFeatures;
+                bufferDeviceAddress = true;
+            }
+        }
+        deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
+
         VkDevice device;
         if (
             vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) !=
@@ -213,7 +265,10 @@ namespace mynydd {
             throw std::runtime_error("Failed to create logical device");
         }
 
-        vkGetDeviceQueue(device, computeQueueFamilyIndex, 0, &computeQueue);
+        computeQueues.resize(queueCount);
+        for (uint32_t i = 0; i < queueCount; ++i) {
+            vkGetDeviceQueue(device, computeQueueFamilyIndex, i, &computeQueues[i]);
+        }
         return device;
     }
 
@@ -240,7 +295,8 @@ namespace mynydd {
         VkPhysicalDevice physicalDevice,
         VkDevice device,
         VkBuffer buffer,
-        VkMemoryPropertyFlags properties
+        VkMemoryPropertyFlags properties,
+        VkMemoryAllocateFlags allocateFlags
     ) {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
@@ -270,6 +326,13 @@ namespace mynydd {
         allocInfo.allocationSize = memRequirements.size;
         allocInfo.memoryTypeIndex = memoryTypeIndex;
 
+        VkMemoryAllocateFlagsInfo flagsInfo{};
+        if (allocateFlags != 0) {
+            flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+            flagsInfo.flags = allocateFlags;
+            allocInfo.pNext = &flagsInfo;
+        }
+
         VkDeviceMemory memory;
         if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
             throw std::runtime_error("Failed to allocate buffer memory");
@@ -280,12 +343,12 @@ namespace mynydd {
     }
 
     /**
-    * Loads a SPIR-V shader module from file.
+    * Reads a SPIR-V binary from file.
     */
-    VkShaderModule loadShaderModule(VkDevice device, const char *filepath) {
+    std::vector<uint32_t> readShaderFile(const char *filepath) {
         std::ifstream file(filepath, std::ios::binary | std::ios::ate);
         if (!file.is_open()) {
-            throw std::runtime_error("Failed to open shader file");
+            throw std::runtime_error(std::string("Failed to open shader file: ") + filepath);
         }
 
         size_t fileSize = (size_t)file.tellg();
@@ -293,11 +356,14 @@ namespace mynydd {
         file.seekg(0);
         file.read(reinterpret_cast<char *>(buffer.data()), fileSize);
         file.close();
+        return buffer;
+    }
 
+    VkShaderModule createShaderModule(VkDevice device, const std::vector<uint32_t> &code) {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = buffer.size() * sizeof(uint32_t);
-        createInfo.pCode = buffer.data();
+        createInfo.codeSize = code.size() * sizeof(uint32_t);
+        createInfo.pCode = code.data();
 
         VkShaderModule shaderModule;
         if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) !=
@@ -308,6 +374,13 @@ namespace mynydd {
         return shaderModule;
     }
 
+    /**
+    * Loads a SPIR-V shader module from file.
+    */
+    VkShaderModule loadShaderModule(VkDevice device, const char *filepath) {
+        return createShaderModule(device, readShaderFile(filepath));
+    }
+
     VkDescriptorSetLayout createDescriptorSetLayout(
         VkDevice device,
         const std::vector<std::shared_ptr<Buffer>>& buffers
@@ -391,8 +464,8 @@ namespace mynydd {
         for (const auto &buffer : buffers) {
             VkDescriptorBufferInfo bufferInfo{};
             bufferInfo.buffer = buffer->getBuffer();
-            bufferInfo.offset = 0;
-            bufferInfo.range = buffer->getSize();
+            bufferInfo.offset = buffer->getOffset();
+            bufferInfo.range = buffer->getRange();
 
             bufferInfos.push_back(bufferInfo);
 
@@ -417,15 +490,12 @@ namespace mynydd {
         );
     }
     
-    VkPipeline createComputePipeline(
+    VkPipelineLayout createPipelineLayout(
         VkDevice device,
         VkPhysicalDevice physicalDevice,
-        VkShaderModule shaderModule,
         VkDescriptorSetLayout descriptorSetLayout,
-        VkPipelineLayout &pipelineLayout,
-        std::vector<uint32_t> pushConstantSizes = {}
+        const std::vector<uint32_t> &pushConstantSizes
     ) {
-
         VkPipelineLayoutCreateInfo layoutInfo{};
         layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         layoutInfo.setLayoutCount = 1;
@@ -435,48 +505,46 @@ namespace mynydd {
         vkGetPhysicalDeviceProperties(physicalDevice, &props);
         uint32_t maxPushConstants = props.limits.maxPushConstantsSize;
 
-        if (!pushConstantSizes.empty()) {
-            std::vector<VkPushConstantRange> ranges;
-            ranges.reserve(pushConstantSizes.size());
-
-            uint32_t offset = 0;
-            for (size_t j = 0; j < pushConstantSizes.size(); ++j) {
-                uint32_t s = pushConstantSizes[j];
-
-                if (s == 0) {
-                    throw std::runtime_error("Push constant size must be > 0");
-                }
-                if ((s % 4) != 0) {
-                    throw std::runtime_error("Push constant size must be a multiple of 4");
-                }
-                if (offset + s > maxPushConstants) {
-                    throw std::runtime_error("Push constants exceed device maxPushConstantsSize");
-                }
-
-                VkPushConstantRange r{};
-                r.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-                r.offset = offset;
-                r.size = s;
-                ranges.push_back(r);
-
-                offset += s;
-            }
+        std::vector<VkPushConstantRange> ranges;
+        ranges.reserve(pushConstantSizes.size());
 
-            layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
-            layoutInfo.pPushConstantRanges = ranges.data();
+        uint32_t offset = 0;
+        for (size_t j = 0; j < pushConstantSizes.size(); ++j) {
+            uint32_t s = pushConstantSizes[j];
 
-            // CreatePipelineLayout must be called while `ranges` is in scope
-            if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-                throw std::runtime_error("vkCreatePipelineLayout failed");
+            if (s == 0) {
+                throw std::runtime_error("Push constant size must be > 0");
             }
-        } else {
-            // no push constants
-            layoutInfo.pushConstantRangeCount = 0;
-            layoutInfo.pPushConstantRanges = nullptr;
-            if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-                throw std::runtime_error("vkCreatePipelineLayout failed");
+            if ((s % 4) != 0) {
+                throw std::runtime_error("Push constant size must be a multiple of 4");
+            }
+            if (offset + s > maxPushConstants) {
+                throw std::runtime_error("Push constants exceed device maxPushConstantsSize");
             }
+
+            VkPushConstantRange r{};
+            r.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            r.offset = offset;
+            r.size = s;
+            ranges.push_back(r);
+
+            offset += s;
         }
+
+        layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
+        layoutInfo.pPushConstantRanges = ranges.empty() ? nullptr : ranges.data();
+
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("vkCreatePipelineLayout failed");
+        }
+        return pipelineLayout;
+    }
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo(
+        VkShaderModule shaderModule,
+        VkPipelineLayout pipelineLayout
+    ) {
         VkComputePipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
         pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -484,12 +552,26 @@ namespace mynydd {
         pipelineInfo.stage.module = shaderModule;
         pipelineInfo.stage.pName = "main";
         pipelineInfo.layout = pipelineLayout;
+        return pipelineInfo;
+    }
+
+    VkPipeline createComputePipeline(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        VkShaderModule shaderModule,
+        VkDescriptorSetLayout descriptorSetLayout,
+        VkPipelineLayout &pipelineLayout,
+        std::vector<uint32_t> pushConstantSizes = {},
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE
+    ) {
+        pipelineLayout = createPipelineLayout(device, physicalDevice, descriptorSetLayout, pushConstantSizes);
+        VkComputePipelineCreateInfo pipelineInfo = computePipelineCreateInfo(shaderModule, pipelineLayout);
 
         VkPipeline pipeline;
         if (
             vkCreateComputePipelines(
                 device,
-                VK_NULL_HANDLE,
+                pipelineCache,
                 1,
                 &pipelineInfo,
                 nullptr,
@@ -499,9 +581,6 @@ namespace mynydd {
             throw std::runtime_error("Failed to create compute pipeline");
         }
 
-        // std::cerr << "Using pipeline = " << 
-        //     pipeline << ", layout to bind = " << pipelineLayout << ", descriptorSet = " << descriptorSetLayout << std::endl;
-
         return pipeline;
     }
 
@@ -537,11 +616,12 @@ namespace mynydd {
 
     VulkanPipelineResources create_pipeline_resources(
         std::shared_ptr<VulkanContext> contextPtr,
-        const char* shaderPath,
+        const std::vector<uint32_t>& code,
+        const std::string& shaderName,
         VkDescriptorSetLayout &descriptorLayout,
         std::vector<uint32_t> pushConstantSizes
     ) {
-        VkShaderModule shader = loadShaderModule(contextPtr->device, shaderPath);
+        VkShaderModule shader = createShaderModule(contextPtr->device, code);
 
         VkPipelineLayout pipelineLayout;
         VkPipeline computePipeline = createComputePipeline(
@@ -550,10 +630,11 @@ namespace mynydd {
             shader,
             descriptorLayout,
             pipelineLayout,
-            pushConstantSizes
+            pushConstantSizes,
+            contextPtr->pipelineCache
         );
 
-        std::cerr << "Creating pipeline " << computePipeline << " for shader: " << shaderPath << std::endl;
+        std::cerr << "Creating pipeline " << computePipeline << " for shader: " << shaderName << std::endl;
 
 
         return {
@@ -575,13 +656,27 @@ namespace mynydd {
         device = createLogicalDevice(
             physicalDevice,
             computeQueueFamilyIndex,
-            computeQueue
+            computeQueues,
+            bufferDeviceAddress
         );
+        computeQueue = computeQueues[0];
+
+        if (bufferDeviceAddress) {
+            getBufferDeviceAddress = (PFN_vkGetBufferDeviceAddressKHR)
+                vkGetDeviceProcAddr(device, "vkGetBufferDeviceAddressKHR");
+            bufferDeviceAddress = getBufferDeviceAddress != nullptr;
+        }
 
         commandPool = createCommandPool(
             device, computeQueueFamilyIndex
         );
 
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache");
+        }
+
         commandBuffer = allocateCommandBuffer(
             device, commandPool
         );
@@ -598,9 +693,32 @@ namespace mynydd {
         const std::vector<std::shared_ptr<Buffer>> buffers
     ) : contextPtr(contextPtr) {
 
+        // A descriptor beyond the device range limit is invalid and, on most drivers,
+        // silently clamped, so reject it here; large arrays can be bound in chunks
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(contextPtr->physicalDevice, &props);
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            bool uniform = buffers[i]->getType() != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            VkDeviceSize limit = uniform ? props.limits.maxUniformBufferRange : props.limits.maxStorageBufferRange;
+            if (buffers[i]->getRange() > limit) {
+                throw std::runtime_error(
+                    "Binding " + std::to_string(i) + " covers " + std::to_string(buffers[i]->getRange()) +
+                    " bytes, above the device limit of " + std::to_string(limit) +
+                    "; bind it in chunks, see maxElementsPerBinding and splitBuffer"
+                );
+            }
+        }
+
         descriptorSetLayout = createDescriptorSetLayout(contextPtr->device, buffers);
 
+        if (buffers.empty()) {
+            // Bindless step: buffers are reached through device addresses instead
+            return;
+        }
+
         descriptorSet = allocateDescriptorSet(contextPtr->device, descriptorSetLayout, descriptorPool, buffers);
+        RuntimeMetrics::count(contextPtr->metrics->descriptorPoolsCreated);
+        RuntimeMetrics::count(contextPtr->metrics->descriptorSetsAllocated);
 
         updateDescriptorSet(
             contextPtr->device,
@@ -610,10 +728,62 @@ namespace mynydd {
     }
 
 
+    std::shared_ptr<UniformRing> getUniformRing(std::shared_ptr<VulkanContext> contextPtr) {
+        if (!contextPtr->uniformRing) {
+            contextPtr->uniformRing = std::make_shared<UniformRing>(contextPtr);
+        }
+        return contextPtr->uniformRing;
+    }
+
+    bool loadPipelineCache(std::shared_ptr<VulkanContext> contextPtr, const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        size_t fileSize = (size_t)file.tellg();
+        std::vector<char> data(fileSize);
+        file.seekg(0);
+        file.read(data.data(), fileSize);
+
+        // The driver validates the header and silently starts empty on a mismatch
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.data();
+
+        VkPipelineCache loaded;
+        if (vkCreatePipelineCache(contextPtr->device, &cacheInfo, nullptr, &loaded) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache from " + path);
+        }
+        VkResult result = vkMergePipelineCaches(contextPtr->device, contextPtr->pipelineCache, 1, &loaded);
+        vkDestroyPipelineCache(contextPtr->device, loaded, nullptr);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to merge pipeline cache from " + path);
+        }
+        return true;
+    }
+
+    void savePipelineCache(std::shared_ptr<VulkanContext> contextPtr, const std::string& path) {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(contextPtr->device, contextPtr->pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to query pipeline cache size");
+        }
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(contextPtr->device, contextPtr->pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to read pipeline cache data");
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open pipeline cache file for writing: " + path);
+        }
+        file.write(data.data(), dataSize);
+    }
+
     void recordCommandBuffer(
         VkCommandBuffer cmdBuffer,
         std::shared_ptr<PipelineStep> pipeline_step,
-        bool memory_barrier = true
+        bool memory_barrier
     ) {
             const auto& pipeline      = pipeline_step->getPipelineResourcesPtr()->pipeline;
             const auto& layout        = pipeline_step->getPipelineResourcesPtr()->pipelineLayout;
@@ -622,13 +792,22 @@ namespace mynydd {
             // std::cerr << "Binding pipeline " << pipeline 
             //         << " layout=" << layout 
             //         << " descriptorSet=" << descriptorSet << std::endl;
-            if (pipeline == VK_NULL_HANDLE || layout == VK_NULL_HANDLE || descriptorSet == VK_NULL_HANDLE) {
-                throw std::runtime_error("Invalid pipeline or descriptor set for engine step.");
+            if (pipeline == VK_NULL_HANDLE || layout == VK_NULL_HANDLE) {
+                throw std::runtime_error("Invalid pipeline for engine step.");
             }
 
             // Bind pipeline and descriptor sets
             vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
-            vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &descriptorSet, 0, nullptr);
+            // Bindless steps have no descriptor set; their buffers are reached by address
+            if (descriptorSet != VK_NULL_HANDLE) {
+                // Dynamic offsets are copied into the command buffer here, so the step's
+                // offsets may be changed again before it is next recorded
+                const auto& dynamicOffsets = pipeline_step->getDynamicOffsets();
+                vkCmdBindDescriptorSets(
+                    cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &descriptorSet,
+                    static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data()
+                );
+            }
 
 
             if (pipeline_step->hasPushConstantData()) {
@@ -645,15 +824,23 @@ namespace mynydd {
                 );
             }
 
-            // Dispatch compute shader
+            // Dispatch compute shader, bracketed by timestamps when tracing
+            Tracer* tracer = pipeline_step->getContextPtr()->tracer.get();
+            bool timed = tracer && tracer->beginGpuRange(cmdBuffer, pipeline_step->getName());
             vkCmdDispatch(cmdBuffer, 
                 pipeline_step->groupCountX,
                 pipeline_step->groupCountY,
                 pipeline_step->groupCountZ
             );
+            if (timed) {
+                tracer->endGpuRange(cmdBuffer);
+            }
 
             // Insert memory barrier between shaders (except after last one)
+            // A step that only reads needs no memory dependency, just an execution one so
+            // that later writes cannot overtake its reads
             if (memory_barrier) {
+                bool writes = pipeline_step->getReflection().writesMemory();
                 VkMemoryBarrier memoryBarrier{};
                 memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
                 memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
@@ -663,14 +850,58 @@ namespace mynydd {
                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                     0,
-                    1, &memoryBarrier,
+                    writes ? 1 : 0, writes ? &memoryBarrier : nullptr,
                     0, nullptr,
                     0, nullptr
                 );
+                RuntimeMetrics::count(pipeline_step->getContextPtr()->metrics->barriers);
             }
 
     }
 
+    void recordFillBuffer(
+        VkCommandBuffer cmdBuffer,
+        std::shared_ptr<VulkanContext> contextPtr,
+        std::shared_ptr<Buffer> buffer,
+        uint32_t value
+    ) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer->getBuffer();
+        barrier.offset = buffer->getOffset();
+        barrier.size = buffer->getSize();
+
+        // Earlier shader reads and writes of the range finish before the fill
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr
+        );
+
+        vkCmdFillBuffer(cmdBuffer, buffer->getBuffer(), buffer->getOffset(), buffer->getSize(), value);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            cmdBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr
+        );
+        RuntimeMetrics::count(contextPtr->metrics->barriers, 2);
+    }
+
     PipelineStep::PipelineStep(
         std::shared_ptr<VulkanContext> contextPtr, 
         const char* shaderPath,
@@ -679,17 +910,128 @@ namespace mynydd {
         uint32_t groupCountY,
         uint32_t groupCountZ,
         std::vector<uint32_t> pushConstantSizes
-    ) : contextPtr(contextPtr), groupCountX(groupCountX), groupCountY(groupCountY), groupCountZ(groupCountZ) {  
+    ) : PipelineStep(
+            contextPtr, readShaderFile(shaderPath), shaderPath, std::move(buffers),
+            groupCountX, groupCountY, groupCountZ, std::move(pushConstantSizes)
+        ) {}
+
+    PipelineStep::PipelineStep(
+        std::shared_ptr<VulkanContext> contextPtr,
+        const std::vector<uint32_t>& spirv,
+        const std::string& name,
+        std::vector<std::shared_ptr<Buffer>> buffers,
+        uint32_t groupCountX,
+        uint32_t groupCountY,
+        uint32_t groupCountZ,
+        std::vector<uint32_t> pushConstantSizes
+    ) : contextPtr(contextPtr), groupCountX(groupCountX), groupCountY(groupCountY), groupCountZ(groupCountZ),
+        m_name(name), m_spirv(spirv) {
+        m_reflection = reflectSpirv(spirv);
+        validateShaderInterface(m_reflection, buffers, pushConstantSizes, name);
+
+        for (const auto& buffer : buffers) {
+            if (buffer->isDynamic()) {
+                m_dynamicOffsets.push_back(0);
+            }
+            m_bindingSizes.push_back(buffer->isDynamic() ? buffer->getRange() : buffer->getSize());
+            m_buffers.push_back(buffer);
+        }
         this->dynamicResourcesPtr = std::make_shared<mynydd::VulkanDynamicResources>(
             contextPtr,
             buffers
         );
         assert(this->dynamicResourcesPtr->descriptorSetLayout != VK_NULL_HANDLE);
         this->pipelineResources = std::make_shared<VulkanPipelineResources>(
-            create_pipeline_resources(contextPtr, shaderPath, this->dynamicResourcesPtr->descriptorSetLayout, pushConstantSizes)
+            create_pipeline_resources(contextPtr, spirv, name, this->dynamicResourcesPtr->descriptorSetLayout, pushConstantSizes)
         );
     }
 
+    PipelineStep::PipelineStep(
+        std::shared_ptr<VulkanContext> contextPtr,
+        std::shared_ptr<VulkanDynamicResources> dynamicResources,
+        VulkanPipelineResources pipelineResources,
+        ShaderReflection reflection,
+        const std::vector<std::shared_ptr<Buffer>>& buffers,
+        uint32_t groupCountX,
+        uint32_t groupCountY,
+        uint32_t groupCountZ,
+        const std::string& name,
+        std::vector<uint32_t> spirv
+    ) : groupCountX(groupCountX), groupCountY(groupCountY), groupCountZ(groupCountZ),
+        contextPtr(contextPtr), dynamicResourcesPtr(dynamicResources), m_reflection(std::move(reflection)),
+        m_name(name), m_spirv(std::move(spirv)) {
+        for (const auto& buffer : buffers) {
+            if (buffer->isDynamic()) {
+                m_dynamicOffsets.push_back(0);
+            }
+            m_bindingSizes.push_back(buffer->isDynamic() ? buffer->getRange() : buffer->getSize());
+            m_buffers.push_back(buffer);
+        }
+        this->pipelineResources = std::make_shared<VulkanPipelineResources>(pipelineResources);
+    }
+
+    std::array<uint32_t, 3> foldGroupCount(uint64_t groups, uint32_t maxGroupCountX, uint32_t maxGroupCountY) {
+        if (groups <= maxGroupCountX) {
+            return {static_cast<uint32_t>(std::max<uint64_t>(groups, 1)), 1, 1};
+        }
+        // As few rows as possible, then rows as short as possible, to limit the idle
+        // workgroups in the last row
+        uint64_t rows = (groups + maxGroupCountX - 1) / maxGroupCountX;
+        if (rows > maxGroupCountY) {
+            throw std::runtime_error(
+                std::to_string(groups) + " workgroups exceed maxComputeWorkGroupCount even when folded into 2D"
+            );
+        }
+        uint64_t columns = (groups + rows - 1) / rows;
+        return {static_cast<uint32_t>(columns), static_cast<uint32_t>(rows), 1};
+    }
+
+    std::array<uint32_t, 3> foldGroupCount(std::shared_ptr<VulkanContext> contextPtr, uint64_t groups) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(contextPtr->physicalDevice, &props);
+        return foldGroupCount(
+            groups, props.limits.maxComputeWorkGroupCount[0], props.limits.maxComputeWorkGroupCount[1]
+        );
+    }
+
+    void PipelineStep::dispatchForElements(uint64_t nElements) {
+        uint64_t localSize = m_reflection.localSize[0];
+        uint64_t groups = (nElements + localSize - 1) / localSize;
+        setGroupCount(foldGroupCount(contextPtr, groups));
+    }
+
+    std::vector<std::shared_ptr<Buffer>> PipelineStep::getBuffers() const {
+        std::vector<std::shared_ptr<Buffer>> buffers;
+        for (const auto& weak : m_buffers) {
+            auto buffer = weak.lock();
+            if (!buffer) {
+                throw std::runtime_error("A buffer bound to step " + m_name + " has been destroyed");
+            }
+            buffers.push_back(buffer);
+        }
+        return buffers;
+    }
+
+    WorkloadModel PipelineStep::estimateWorkloadModel() const {
+        WorkloadModel model;
+        for (const ReflectedBinding& binding : m_reflection.bindings) {
+            if (binding.set != 0 || binding.binding >= m_bindingSizes.size()) {
+                continue;
+            }
+            VkDeviceSize size = m_bindingSizes[binding.binding];
+            bool storage = binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            if (!binding.writeOnly) {
+                model.bytesRead += size;
+            }
+            if (storage && !binding.readOnly) {
+                model.bytesWritten += size;
+            }
+        }
+        model.ops = static_cast<uint64_t>(groupCountX) * groupCountY * groupCountZ *
+            m_reflection.localSize[0] * m_reflection.localSize[1] * m_reflection.localSize[2];
+        return model;
+    }
+
     PipelineStep::~PipelineStep() {
         try {
             if (this->contextPtr && this->contextPtr->device != VK_NULL_HANDLE &&
@@ -720,8 +1062,16 @@ namespace mynydd {
             throw std::runtime_error("Invalid Vulkan context in batch execution.");
         }
 
+        if (!contextPtr->capturePath.empty()) {
+            std::string path;
+            std::swap(path, contextPtr->capturePath);
+            writeCapture(captureBatch(contextPtr, PipelineSteps, !beginCommandBuffer), path);
+        }
+
         VkCommandBuffer cmdBuffer = contextPtr->commandBuffer;
+        Tracer* tracer = contextPtr->tracer.get();
 
+        std::optional<TraceScope> recordScope(std::in_place, tracer, "record");
         if (beginCommandBuffer) {
             VkCommandBufferBeginInfo beginInfo{};
             beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -742,6 +1092,15 @@ namespace mynydd {
             );
         }
 
+        recordScope.reset();
+
+        submitAndWait(contextPtr);
+    }
+
+    void submitAndWait(std::shared_ptr<VulkanContext> contextPtr) {
+        VkCommandBuffer cmdBuffer = contextPtr->commandBuffer;
+        Tracer* tracer = contextPtr->tracer.get();
+
         if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS) {
             throw std::runtime_error("Failed to end command buffer for batch execution.");
         }
@@ -759,12 +1118,33 @@ namespace mynydd {
             throw std::runtime_error("Failed to create fence for batch execution.");
         }
 
-        if (vkQueueSubmit(contextPtr->computeQueue, 1, &submitInfo, fence) != VK_SUCCESS) {
-            vkDestroyFence(contextPtr->device, fence, nullptr);
-            throw std::runtime_error("Failed to submit batched command buffer.");
+        RuntimeMetrics& metrics = *contextPtr->metrics;
+        {
+            TraceScope scope(tracer, "submit");
+            if (vkQueueSubmit(contextPtr->computeQueue, 1, &submitInfo, fence) != VK_SUCCESS) {
+                vkDestroyFence(contextPtr->device, fence, nullptr);
+                throw std::runtime_error("Failed to submit batched command buffer.");
+            }
+            RuntimeMetrics::count(metrics.submits);
+        }
+        {
+            TraceScope scope(tracer, "wait");
+            auto waitStart = std::chrono::steady_clock::now();
+            vkWaitForFences(contextPtr->device, 1, &fence, VK_TRUE, UINT64_MAX);
+            RuntimeMetrics::count(metrics.fenceWaits);
+            RuntimeMetrics::count(metrics.fenceWaitNs, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - waitStart
+            ).count());
         }
-        vkWaitForFences(contextPtr->device, 1, &fence, VK_TRUE, UINT64_MAX);
         vkDestroyFence(contextPtr->device, fence, nullptr);
+        if (tracer) {
+            tracer->resolveGpuRanges();
+        }
+
+        // Everything pushed to the uniform ring so far has now been consumed
+        if (contextPtr->uniformRing) {
+            contextPtr->uniformRing->release();
+        }
     }
 
 
@@ -0,0 +1,152 @@
+#include <future>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include "../include/mynydd/pipeline_builder.hpp"
+
+namespace mynydd {
+
+    PipelineBuilder::PipelineBuilder(std::shared_ptr<VulkanContext> contextPtr) : contextPtr(contextPtr) {
+        if (!contextPtr || contextPtr->device == VK_NULL_HANDLE) {
+            throw std::runtime_error("Invalid Vulkan context for pipeline builder.");
+        }
+    }
+
+    size_t PipelineBuilder::add(
+        const char* shaderPath,
+        std::vector<std::shared_ptr<Buffer>> buffers,
+        uint32_t groupCountX,
+        uint32_t groupCountY,
+        uint32_t groupCountZ,
+        std::vector<uint32_t> pushConstantSizes
+    ) {
+        steps.push_back({shaderPath, {}, std::move(buffers), groupCountX, groupCountY, groupCountZ, std::move(pushConstantSizes)});
+        return steps.size() - 1;
+    }
+
+    size_t PipelineBuilder::add(
+        const std::vector<uint32_t>& spirv,
+        const std::string& name,
+        std::vector<std::shared_ptr<Buffer>> buffers,
+        uint32_t groupCountX,
+        uint32_t groupCountY,
+        uint32_t groupCountZ,
+        std::vector<uint32_t> pushConstantSizes
+    ) {
+        if (spirv.empty()) {
+            throw std::runtime_error("Empty SPIR-V given for " + name);
+        }
+        steps.push_back({name, spirv, std::move(buffers), groupCountX, groupCountY, groupCountZ, std::move(pushConstantSizes)});
+        return steps.size() - 1;
+    }
+
+    std::vector<std::shared_ptr<PipelineStep>> PipelineBuilder::build() {
+        if (steps.empty()) {
+            return {};
+        }
+        VkDevice device = contextPtr->device;
+
+        // Read every distinct SPIR-V file concurrently
+        std::map<std::string, std::future<std::vector<uint32_t>>> reads;
+        for (const auto& step : steps) {
+            if (step.code.empty() && reads.find(step.shaderPath) == reads.end()) {
+                reads.emplace(step.shaderPath, std::async(std::launch::async, [path = step.shaderPath]() {
+                    return readShaderFile(path.c_str());
+                }));
+            }
+        }
+        std::map<std::string, std::vector<uint32_t>> files;
+        for (auto& [path, future] : reads) {
+            files.emplace(path, future.get());
+        }
+        auto codeFor = [&](const StepDesc& step) -> const std::vector<uint32_t>& {
+            return step.code.empty() ? files.at(step.shaderPath) : step.code;
+        };
+
+        // Reject mismatched bindings before creating any Vulkan objects
+        std::vector<ShaderReflection> reflections;
+        for (const StepDesc& step : steps) {
+            reflections.push_back(reflectSpirv(codeFor(step)));
+            validateShaderInterface(reflections.back(), step.buffers, step.pushConstantSizes, step.shaderPath);
+        }
+
+        // Each step owns its module and layout, as with the PipelineStep constructor
+        std::vector<std::shared_ptr<VulkanDynamicResources>> dynamicResources;
+        std::vector<VulkanPipelineResources> resources(steps.size(), {VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE});
+        std::vector<VkComputePipelineCreateInfo> createInfos;
+        auto cleanup = [&]() {
+            for (auto& r : resources) {
+                if (r.pipelineLayout != VK_NULL_HANDLE) {
+                    vkDestroyPipelineLayout(device, r.pipelineLayout, nullptr);
+                }
+                if (r.computeShaderModule != VK_NULL_HANDLE) {
+                    vkDestroyShaderModule(device, r.computeShaderModule, nullptr);
+                }
+            }
+        };
+
+        try {
+            for (size_t i = 0; i < steps.size(); ++i) {
+                const StepDesc& step = steps[i];
+                dynamicResources.push_back(std::make_shared<VulkanDynamicResources>(contextPtr, step.buffers));
+                resources[i].computeShaderModule = createShaderModule(device, codeFor(step));
+                resources[i].pipelineLayout = createPipelineLayout(
+                    device,
+                    contextPtr->physicalDevice,
+                    dynamicResources.back()->descriptorSetLayout,
+                    step.pushConstantSizes
+                );
+                createInfos.push_back(computePipelineCreateInfo(resources[i].computeShaderModule, resources[i].pipelineLayout));
+            }
+        } catch (...) {
+            cleanup();
+            throw;
+        }
+
+        std::vector<VkPipeline> pipelines(steps.size(), VK_NULL_HANDLE);
+        if (
+            vkCreateComputePipelines(
+                device,
+                contextPtr->pipelineCache,
+                static_cast<uint32_t>(createInfos.size()),
+                createInfos.data(),
+                nullptr,
+                pipelines.data()
+            ) != VK_SUCCESS
+        ) {
+            for (VkPipeline pipeline : pipelines) {
+                if (pipeline != VK_NULL_HANDLE) {
+                    vkDestroyPipeline(device, pipeline, nullptr);
+                }
+            }
+            cleanup();
+            throw std::runtime_error("Failed to create compute pipelines in batch");
+        }
+
+        std::vector<std::shared_ptr<PipelineStep>> result;
+        result.reserve(steps.size());
+        for (size_t i = 0; i < steps.size(); ++i) {
+            resources[i].pipeline = pipelines[i];
+            const StepDesc& step = steps[i];
+            result.push_back(std::make_shared<PipelineStep>(
+                contextPtr,
+                dynamicResources[i],
+                resources[i],
+                reflections[i],
+                step.buffers,
+                step.groupCountX,
+                step.groupCountY,
+                step.groupCountZ,
+                step.shaderPath,
+                codeFor(step)
+            ));
+        }
+        steps.clear();
+        return result;
+    }
+
+}
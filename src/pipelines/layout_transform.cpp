@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/embedded_shaders.hpp"
+#include "../include/mynydd/pipeline_builder.hpp"
+#include "../include/mynydd/pipelines/layout_transform.hpp"
+
+namespace mynydd {
+
+    namespace {
+        // Must match TILE_WORDS in layout_transform.comp
+        const uint32_t tileWords = 2048;
+    }
+
+    AosLayout AosLayout::packed(uint32_t recordStrideBytes, uint32_t elementBytes, uint32_t n) {
+        AosLayout layout{recordStrideBytes, elementBytes, {}};
+        for (uint32_t c = 0; c < n; ++c) {
+            layout.componentOffsets.push_back(c * elementBytes);
+        }
+        return layout;
+    }
+
+    LayoutTransformPipeline::LayoutTransformPipeline(
+        std::shared_ptr<VulkanContext> contextPtr,
+        std::shared_ptr<Buffer> aosBuffer,
+        std::shared_ptr<Buffer> soaBuffer,
+        uint32_t count,
+        const AosLayout& layout,
+        uint64_t soaPitchBytes
+    ) : contextPtr(contextPtr), params{} {
+        const uint32_t e = layout.elementBytes;
+        const size_t nComponents = layout.componentOffsets.size();
+        if (e != 4 && e != 8 && e != 16) {
+            throw std::runtime_error("Layout transform supports 4, 8 or 16 byte members, not " + std::to_string(e));
+        }
+        if (nComponents == 0 || nComponents > LayoutParams::maxComponents) {
+            throw std::runtime_error(
+                "Layout transform needs between 1 and " + std::to_string(LayoutParams::maxComponents) + " members"
+            );
+        }
+        if (layout.recordStrideBytes % 4 != 0) {
+            throw std::runtime_error("AoS record stride must be a multiple of 4 bytes");
+        }
+        for (uint32_t offset : layout.componentOffsets) {
+            if (offset % 4 != 0 || offset + e > layout.recordStrideBytes) {
+                throw std::runtime_error(
+                    "Member at byte " + std::to_string(offset) + " is misaligned or outside the " +
+                    std::to_string(layout.recordStrideBytes) + " byte record"
+                );
+            }
+        }
+        if (count == 0) {
+            throw std::runtime_error("Layout transform needs at least one record");
+        }
+
+        if (soaPitchBytes == 0) {
+            soaPitchBytes = uint64_t(count) * e;
+        }
+        if (soaPitchBytes % 4 != 0 || soaPitchBytes < uint64_t(count) * e) {
+            throw std::runtime_error("SoA pitch must be a multiple of 4 bytes and hold count members");
+        }
+        if (aosBuffer->getSize() < uint64_t(count) * layout.recordStrideBytes) {
+            throw std::runtime_error("AoS buffer is smaller than count records");
+        }
+        uint64_t soaBytes = (nComponents - 1) * soaPitchBytes + uint64_t(count) * e;
+        if (soaBuffer->getSize() < soaBytes) {
+            throw std::runtime_error(
+                "SoA buffer holds " + std::to_string(soaBuffer->getSize()) + " bytes, " +
+                std::to_string(soaBytes) + " needed"
+            );
+        }
+        // The kernel indexes in 32-bit words
+        if (aosBuffer->getSize() / 4 > UINT32_MAX || soaBytes / 4 > UINT32_MAX) {
+            throw std::runtime_error("Layout transform buffers must be below 16 GiB");
+        }
+
+        params.count = count;
+        params.recordWords = layout.recordStrideBytes / 4;
+        params.elementWords = e / 4;
+        params.componentCount = static_cast<uint32_t>(nComponents);
+        params.soaPitchWords = static_cast<uint32_t>(soaPitchBytes / 4);
+        params.tileRecords = tileWords / (params.componentCount * params.elementWords);
+        for (size_t c = 0; c < nComponents; ++c) {
+            params.componentOffsetWords[c] = layout.componentOffsets[c] / 4;
+        }
+
+        const std::array<uint32_t, 3> groups = foldGroupCount(
+            contextPtr, (uint64_t(count) + params.tileRecords - 1) / params.tileRecords
+        );
+        const std::vector<uint32_t> spirv = getEmbeddedShader("layout_transform.comp");
+        const std::vector<std::shared_ptr<Buffer>> buffers{aosBuffer, soaBuffer};
+
+        PipelineBuilder builder(contextPtr);
+        size_t toSoaIdx = builder.add(
+            spirv, "layout_transform.comp", buffers, groups[0], groups[1], 1,
+            std::vector<uint32_t>{sizeof(LayoutParams)}
+        );
+        size_t toAosIdx = builder.add(
+            spirv, "layout_transform.comp", buffers, groups[0], groups[1], 1,
+            std::vector<uint32_t>{sizeof(LayoutParams)}
+        );
+        auto steps = builder.build();
+        toSoaStep = steps[toSoaIdx];
+        toAosStep = steps[toAosIdx];
+
+        LayoutParams toSoaParams = params;
+        toSoaParams.toAos = 0;
+        toSoaStep->setPushConstantsData(toSoaParams);
+        LayoutParams toAosParams = params;
+        toAosParams.toAos = 1;
+        toAosStep->setPushConstantsData(toAosParams);
+
+        // Each converted word is read once and written once
+        uint64_t bytesMoved = uint64_t(count) * nComponents * e;
+        toSoaStep->setWorkloadModel({bytesMoved, bytesMoved, 0});
+        toAosStep->setWorkloadModel({bytesMoved, bytesMoved, 0});
+    }
+
+    void LayoutTransformPipeline::toSoa() {
+        executeBatch(contextPtr, {toSoaStep});
+    }
+
+    void LayoutTransformPipeline::toAos() {
+        executeBatch(contextPtr, {toAosStep});
+    }
+
+}
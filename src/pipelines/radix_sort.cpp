@@ -1,103 +1,220 @@
+#include <algorithm>
+#include <array>
 #include <assert.h>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
 
 #include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/embedded_shaders.hpp"
+#include "../include/mynydd/pipeline_builder.hpp"
 #include "../include/mynydd/pipelines/radix_sort.hpp"
+#include "../include/mynydd/pipelines/scan.hpp"
 
 using namespace mynydd;
 
 namespace mynydd {
 
+    namespace {
+        // Must match KEYS_PER_THREAD * local_size_x in radix_upfront_histogram.comp
+        const uint32_t upfrontKeysPerGroup = 16 * 256;
+        // Workgroup size of the multi-pass kernels, which read keys this far apart
+        const uint32_t multiPassWorkgroupSize = 256;
+        const uint32_t maxKeysPerThread = 16;
+        // Onesweep tiles are one key per invocation of the 256-wide scatter kernel
+        const uint32_t onesweepTileSize = 256;
+        // Tile status words keep counts below the two flag bits
+        const uint32_t onesweepMaxElements = (1u << 30) - 1u;
+    }
+
+    RadixSortPipeline::RadixSortPipeline(
+        std::shared_ptr<VulkanContext> contextPtr, 
+        uint32_t itemsPerGroup, 
+        uint32_t nInputElements,
+        uint32_t keyBits
+    ) : RadixSortPipeline(contextPtr, itemsPerGroup, nInputElements, RadixSortOptions{keyBits}) {}
+
     RadixSortPipeline::RadixSortPipeline(
         std::shared_ptr<VulkanContext> contextPtr, 
         uint32_t itemsPerGroup, 
-        uint32_t nInputElements
+        uint32_t nInputElements,
+        const RadixSortOptions& options
     ) : contextPtr(contextPtr),
-        numBins(1 << bitsPerPass), 
-        nPasses(32 / bitsPerPass),
-        nInputElements(nInputElements),
-        groupCount((nInputElements + itemsPerGroup - 1) / itemsPerGroup)
+        bitsPerPass(options.bitsPerPass),
+        keyBits(options.keyBits),
+        backend(options.backend),
+        payload(options.payload),
+        nInputElements(nInputElements)
     {
 
         this->itemsPerGroup = itemsPerGroup;
 
+        if (options.keyBytes != 4 && options.keyBytes != 8) {
+            throw std::runtime_error("Keys are 4 or 8 bytes, not " + std::to_string(options.keyBytes));
+        }
+        keyWords = options.keyBytes / 4;
+        if (keyBits == 0 || keyBits > 32 * keyWords) {
+            throw std::runtime_error(
+                "keyBits must be between 1 and " + std::to_string(32 * keyWords) + ", got " + std::to_string(keyBits)
+            );
+        }
+
+        if (bitsPerPass != 4 && bitsPerPass != 6 && bitsPerPass != 8 && bitsPerPass != 11) {
+            throw std::runtime_error("bitsPerPass must be 4, 6, 8 or 11, got " + std::to_string(bitsPerPass));
+        }
+        numBins = 1u << bitsPerPass;
+        nPasses = (keyBits + bitsPerPass - 1) / bitsPerPass;
+
+        // Each invocation of the 256-wide kernels handles itemsPerGroup / 256 keys
+        if (itemsPerGroup == 0 || itemsPerGroup % multiPassWorkgroupSize != 0 ||
+            itemsPerGroup / multiPassWorkgroupSize > maxKeysPerThread) {
+            throw std::runtime_error(
+                "itemsPerGroup must be a multiple of " + std::to_string(multiPassWorkgroupSize) + " up to " +
+                std::to_string(multiPassWorkgroupSize * maxKeysPerThread) + ", got " + std::to_string(itemsPerGroup)
+            );
+        }
+        groupCount = static_cast<uint32_t>((uint64_t(nInputElements) + itemsPerGroup - 1) / itemsPerGroup);
+
         if (groupCount * itemsPerGroup < nInputElements) {
             throw std::runtime_error("groupCount * itemsPerGroup cannot be less than nInputElements.");
         }
+        // Kernels index the histogram matrices with 32 bits
+        if (uint64_t(groupCount) * numBins > UINT32_MAX) {
+            throw std::runtime_error("Too many workgroups for " + std::to_string(numBins) + " bins; raise itemsPerGroup");
+        }
+
+        switch (payload) {
+            case RadixSortPayload::KeysOnly:
+                payloadWords = 0;
+                break;
+            case RadixSortPayload::Index:
+                payloadWords = 1;
+                break;
+            case RadixSortPayload::Values:
+                if (options.payloadBytes != 4 && options.payloadBytes != 8 &&
+                    options.payloadBytes != 16 && options.payloadBytes != 32) {
+                    throw std::runtime_error(
+                        "Payloads are 4, 8, 16 or 32 bytes, not " + std::to_string(options.payloadBytes)
+                    );
+                }
+                payloadWords = options.payloadBytes / 4;
+                break;
+        }
+        // The scatter kernels index key and payload words with 32 bits
+        if (uint64_t(nInputElements) * std::max(payloadWords, keyWords) > UINT32_MAX) {
+            throw std::runtime_error("Keys or payload of " + std::to_string(nInputElements) + " elements are too large");
+        }
 
-        m_ioBufferA = std::make_shared<mynydd::Buffer>(contextPtr, nInputElements * sizeof(uint32_t), false);
-        m_ioBufferB = std::make_shared<mynydd::Buffer>(contextPtr, nInputElements * sizeof(uint32_t), false);
+        const size_t keyBytes = size_t(nInputElements) * keyWords * sizeof(uint32_t);
+        m_ioBufferA = std::make_shared<mynydd::Buffer>(contextPtr, keyBytes, false);
+        m_ioBufferB = std::make_shared<mynydd::Buffer>(contextPtr, keyBytes, false);
+
+        // Key-only sorts bind a placeholder payload that the kernels never touch
+        if (payloadWords == 0) {
+            m_ioSortedIndicesA = std::make_shared<mynydd::Buffer>(contextPtr, 4 * sizeof(uint32_t), false);
+            m_ioSortedIndicesB = m_ioSortedIndicesA;
+        } else {
+            const size_t payloadBytes = size_t(nInputElements) * payloadWords * sizeof(uint32_t);
+            m_ioSortedIndicesA = std::make_shared<mynydd::Buffer>(contextPtr, payloadBytes, false);
+            m_ioSortedIndicesB = std::make_shared<mynydd::Buffer>(contextPtr, payloadBytes, false);
+        }
 
-        m_ioSortedIndicesA = std::make_shared<mynydd::Buffer>(contextPtr, nInputElements * sizeof(uint32_t), false);
-        m_ioSortedIndicesB = std::make_shared<mynydd::Buffer>(contextPtr, nInputElements * sizeof(uint32_t), false);
+        // One workgroup per tile of input; above maxComputeWorkGroupCount[0] tiles the
+        // kernels run on a 2D grid and recover the tile index with linearWorkGroupID()
+        const std::array<uint32_t, 3> tileGroups = mynydd::foldGroupCount(contextPtr, groupCount);
+
+        // All kernels are created together: shader files are read in parallel and the
+        // pipelines are compiled in one driver call
+        mynydd::PipelineBuilder builder(contextPtr);
+
+        // Index payloads start as 0..n-1 in B, the payload input of the first pass; one
+        // index per invocation, however many keys the sort tiles hold
+        size_t initRangeIdx = SIZE_MAX;
+        if (payload == RadixSortPayload::Index) {
+            const std::array<uint32_t, 3> indexGroups = mynydd::foldGroupCount(
+                contextPtr, (uint64_t(nInputElements) + multiPassWorkgroupSize - 1) / multiPassWorkgroupSize
+            );
+            initRangeIdx = builder.add(
+                mynydd::getEmbeddedShader("init_range_index.comp"), "init_range_index.comp",
+                std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioSortedIndicesB},
+                indexGroups[0],
+                indexGroups[1],
+                1,
+                std::vector<uint32_t>{sizeof(uint32_t)}
+            );
+        }
+
+        StepSlots slots;
+        if (backend == RadixSortBackend::Onesweep) {
+            if (itemsPerGroup != onesweepTileSize || bitsPerPass != 8) {
+                throw std::runtime_error(
+                    "The onesweep backend sorts tiles of " + std::to_string(onesweepTileSize) + " keys by 8-bit digits"
+                );
+            }
+            if (nInputElements > onesweepMaxElements) {
+                throw std::runtime_error("The onesweep backend sorts fewer than 2^30 keys");
+            }
+            slots = addOnesweepSteps(builder, tileGroups);
+        } else {
+            slots = addMultiPassSteps(builder, tileGroups);
+        }
 
-        perWorkgroupHistograms = std::make_shared<mynydd::Buffer>(contextPtr, groupCount * numBins * sizeof(uint32_t), false);
+        auto steps = builder.build();
+        if (initRangeIdx != SIZE_MAX) {
+            initRangePipeline = steps[initRangeIdx];
+        }
+        for (auto& [idx, slot] : slots) {
+            *slot = steps[idx];
+        }
+    }
+
+    RadixSortPipeline::StepSlots RadixSortPipeline::addMultiPassSteps(
+        mynydd::PipelineBuilder& builder,
+        const std::array<uint32_t, 3>& tileGroups
+    ) {
+        // Sizes in 64-bit arithmetic; the histogram buffers grow as groupCount * numBins
+        const size_t histogramBytes = size_t(groupCount) * numBins * sizeof(uint32_t);
+        perWorkgroupHistograms = std::make_shared<mynydd::Buffer>(contextPtr, histogramBytes, false);
         globalHistogram = std::make_shared<mynydd::Buffer>(contextPtr, numBins * sizeof(uint32_t), false);
         globalPrefixSum = std::make_shared<mynydd::Buffer>(contextPtr, numBins * sizeof(uint32_t), false);
-        transposedHistograms = std::make_shared<mynydd::Buffer>(contextPtr, numBins * groupCount * sizeof(uint32_t), false);
-        workgroupPrefixSums = std::make_shared<mynydd::Buffer>(contextPtr, numBins * groupCount * sizeof(uint32_t), false);
-
-        radixUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(RadixParams), true);
-        sumUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(SumParams), true);
-        workgroupPrefixUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(PrefixParams), true);
-        globalPrefixUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(PrefixParams), true);
-        transposeUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(PrefixParams), true);
-        sortUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(SortParams), true);
-
-        initRangePipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/init_range_index.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioSortedIndicesB}, // B will be prev for the first pass
-            groupCount,
-            1,
-            1,
-            std::vector<uint32_t>{sizeof(uint32_t)}
-        );
-    
-        // Load compute pipelines
-        histPipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/histogram.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioBufferA, perWorkgroupHistograms, radixUniform},
-            groupCount
-        );
+        workgroupPrefixSums = std::make_shared<mynydd::Buffer>(contextPtr, histogramBytes, false);
 
-        histPipelinePong = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/histogram.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioBufferB, perWorkgroupHistograms, radixUniform},
-            groupCount
-        );
+        // Digit start offsets: exclusive scan of the global histogram
+        globalPrefixScan = std::make_unique<mynydd::ScanPipeline>(contextPtr, globalHistogram, globalPrefixSum, numBins);
 
-        sumPipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/histogram_sum.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{perWorkgroupHistograms, globalHistogram, sumUniform},
-            1
-        );
+        // Per-pass parameters are sub-allocated from the context uniform ring, so every
+        // recorded dispatch gets its own parameter block
+        auto uniformRing = mynydd::getUniformRing(contextPtr)->getBuffer();
 
-        transposePipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/transpose.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{perWorkgroupHistograms, transposedHistograms, transposeUniform},
-            (numBins * groupCount + numBins - 1) / numBins
+        size_t histIdx = builder.add(
+            mynydd::getEmbeddedShader("histogram.comp"), "histogram.comp",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioBufferA, perWorkgroupHistograms, uniformRing},
+            tileGroups[0], tileGroups[1]
         );
 
-        workgroupPrefixPipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/workgroup_scan.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{transposedHistograms, workgroupPrefixSums, workgroupPrefixUniform},
-            numBins
+        size_t histPongIdx = builder.add(
+            mynydd::getEmbeddedShader("histogram.comp"), "histogram.comp",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioBufferB, perWorkgroupHistograms, uniformRing},
+            tileGroups[0], tileGroups[1]
         );
 
-        globalPrefixPipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/workgroup_scan.comp.spv",
-            std::vector<std::shared_ptr<mynydd::Buffer>>{globalHistogram, globalPrefixSum, globalPrefixUniform},
-            1
+        // Each workgroup scans 16 bin columns of the per-workgroup histograms
+        size_t histogramScanIdx = builder.add(
+            mynydd::getEmbeddedShader("histogram_scan.comp"), "histogram_scan.comp",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{
+                perWorkgroupHistograms, workgroupPrefixSums, globalHistogram, uniformRing
+            },
+            (numBins + 15) / 16
         );
 
-        sortPipeline = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/radix_sort.comp.spv",
+        size_t sortIdx = builder.add(
+            mynydd::getEmbeddedShader("radix_sort.comp"), "radix_sort.comp",
             std::vector<std::shared_ptr<mynydd::Buffer>>{
                 m_ioBufferA,
                 workgroupPrefixSums,
@@ -105,12 +222,12 @@ namespace mynydd {
                 m_ioSortedIndicesB,
                 m_ioBufferB,
                 m_ioSortedIndicesA,
-                sortUniform
+                uniformRing
             },
-            groupCount
+            tileGroups[0], tileGroups[1]
         );
-        sortPipelinePong = std::make_shared<mynydd::PipelineStep>(
-            contextPtr, "shaders/radix_sort.comp.spv",
+        size_t sortPongIdx = builder.add(
+            mynydd::getEmbeddedShader("radix_sort.comp"), "radix_sort.comp",
             std::vector<std::shared_ptr<mynydd::Buffer>>{
                 m_ioBufferB,
                 workgroupPrefixSums,
@@ -118,13 +235,80 @@ namespace mynydd {
                 m_ioSortedIndicesA,
                 m_ioBufferA,
                 m_ioSortedIndicesB,
-                sortUniform
+                uniformRing
+            },
+            tileGroups[0], tileGroups[1]
+        );
+
+        return {
+            {histIdx, &histPipeline},
+            {histPongIdx, &histPipelinePong},
+            {histogramScanIdx, &histogramScanPipeline},
+            {sortIdx, &sortPipeline},
+            {sortPongIdx, &sortPipelinePong}
+        };
+    }
+
+    RadixSortPipeline::StepSlots RadixSortPipeline::addOnesweepSteps(
+        mynydd::PipelineBuilder& builder,
+        const std::array<uint32_t, 3>& tileGroups
+    ) {
+        digitHistograms = std::make_shared<mynydd::Buffer>(contextPtr, nPasses * numBins * sizeof(uint32_t), false);
+        tileStatus = std::make_shared<mynydd::Buffer>(
+            contextPtr, size_t(groupCount) * numBins * sizeof(uint32_t), false
+        );
+        tileCounters = std::make_shared<mynydd::Buffer>(contextPtr, nPasses * sizeof(uint32_t), false);
+
+        const std::array<uint32_t, 3> histogramGroups = mynydd::foldGroupCount(
+            contextPtr, (uint64_t(nInputElements) + upfrontKeysPerGroup - 1) / upfrontKeysPerGroup
+        );
+        size_t upfrontHistogramIdx = builder.add(
+            mynydd::getEmbeddedShader("radix_upfront_histogram.comp"), "radix_upfront_histogram.comp",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{m_ioBufferA, digitHistograms},
+            histogramGroups[0], histogramGroups[1], 1,
+            std::vector<uint32_t>{sizeof(UpfrontHistogramParams)}
+        );
+
+        size_t onesweepIdx = builder.add(
+            mynydd::getEmbeddedShader("radix_onesweep.comp"), "radix_onesweep.comp",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{
+                m_ioBufferA,
+                m_ioSortedIndicesB,
+                m_ioBufferB,
+                m_ioSortedIndicesA,
+                digitHistograms,
+                tileStatus,
+                tileCounters
+            },
+            tileGroups[0], tileGroups[1], 1,
+            std::vector<uint32_t>{sizeof(OnesweepParams)}
+        );
+        size_t onesweepPongIdx = builder.add(
+            mynydd::getEmbeddedShader("radix_onesweep.comp"), "radix_onesweep.comp",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{
+                m_ioBufferB,
+                m_ioSortedIndicesA,
+                m_ioBufferA,
+                m_ioSortedIndicesB,
+                digitHistograms,
+                tileStatus,
+                tileCounters
             },
-            groupCount
+            tileGroups[0], tileGroups[1], 1,
+            std::vector<uint32_t>{sizeof(OnesweepParams)}
         );
+
+        return {
+            {upfrontHistogramIdx, &upfrontHistogramPipeline},
+            {onesweepIdx, &onesweepPipeline},
+            {onesweepPongIdx, &onesweepPipelinePong}
+        };
     }
 
     void RadixSortPipeline::execute_init() {
+        if (!initRangePipeline) {
+            return; // no index payload to initialise
+        }
         // First, initialize the range index buffer
 
         initRangePipeline->setPushConstantsData(nInputElements, 0);
@@ -136,72 +320,98 @@ namespace mynydd {
 
     }
 
-    void RadixSortPipeline::execute() {
-        
-        execute_init();
+    void RadixSortPipeline::record(VkCommandBuffer cmd) {
+        if (initRangePipeline) {
+            initRangePipeline->setPushConstantsData(nInputElements, 0);
+            mynydd::recordCommandBuffer(cmd, initRangePipeline, true);
+        }
 
+        if (backend == RadixSortBackend::Onesweep) {
+            recordOnesweep(cmd);
+            return;
+        }
+
+        // Each push takes a fresh block of the uniform ring and the offsets are captured as
+        // the dispatches are recorded, so all passes can sit in one command buffer
         for (size_t pass = 0; pass < nPasses; ++pass) {
-            execute_pass(pass);
+            for (const auto& step : preparePass(pass)) {
+                mynydd::recordCommandBuffer(cmd, step, true);
+            }
         }
     }
 
+    void RadixSortPipeline::recordOnesweep(VkCommandBuffer cmd) {
+        mynydd::recordFillBuffer(cmd, contextPtr, digitHistograms);
+        mynydd::recordFillBuffer(cmd, contextPtr, tileCounters);
+        upfrontHistogramPipeline->setPushConstantsData(UpfrontHistogramParams{nInputElements, nPasses, keyWords});
+        mynydd::recordCommandBuffer(cmd, upfrontHistogramPipeline, true);
+
+        for (uint32_t pass = 0; pass < nPasses; ++pass) {
+            // Status words are only valid within a pass
+            mynydd::recordFillBuffer(cmd, contextPtr, tileStatus);
+            auto step = pass % 2 == 0 ? onesweepPipeline : onesweepPipelinePong;
+            step->setPushConstantsData(
+                OnesweepParams{pass * bitsPerPass, pass, nInputElements, groupCount, payloadWords, keyWords}
+            );
+            mynydd::recordCommandBuffer(cmd, step, true);
+        }
+    }
+
+    void RadixSortPipeline::execute() {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        if (vkBeginCommandBuffer(contextPtr->commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin command buffer for radix sort.");
+        }
+        record(contextPtr->commandBuffer);
+        mynydd::submitAndWait(contextPtr);
+    }
+
     void RadixSortPipeline::execute_pass(size_t pass) {
+        if (backend != RadixSortBackend::MultiPass) {
+            throw std::runtime_error("execute_pass runs single passes of the multi-pass backend only");
+        }
+        mynydd::executeBatch(contextPtr, preparePass(pass));
+    }
+
+    std::vector<std::shared_ptr<mynydd::PipelineStep>> RadixSortPipeline::preparePass(size_t pass) {
         uint32_t bitOffset = pass * bitsPerPass;
 
         RadixParams radixParams = {
             .bitOffset = bitOffset,
             .numBins = numBins,
             .totalSize = nInputElements,
-            .itemsPerGroup = itemsPerGroup
+            .itemsPerGroup = itemsPerGroup,
+            .keyWords = keyWords
         };
 
-        SumParams sumParams = {
+        SumParams histogramScanParams = {
             .groupCount = groupCount,
             .numBins = numBins
         };
 
-        PrefixParams workgroupPrefixParams = {
-            .groupCount = numBins, // Yes, this is inverted, because it's using the output of transpose shader step
-            .numBins = groupCount
-        };
-
-        PrefixParams transposeParams = {
-            .groupCount = groupCount,
-            .numBins = numBins
-        };
-
-        PrefixParams globalPrefixParams = {
-            .groupCount = 1,
-            .numBins = numBins
-        };
-
         SortParams sortParams = {
             .bitOffset = bitOffset,
             .numBins = numBins,
             .totalSize = nInputElements,
             .workgroupSize=itemsPerGroup,
-            .groupCount=groupCount
+            .groupCount=groupCount,
+            .payloadWords=payloadWords,
+            .keyWords=keyWords
         };
 
-        mynydd::uploadUniformData<RadixParams>(contextPtr, radixParams, radixUniform);
-        mynydd::uploadUniformData<SumParams>(contextPtr, sumParams, sumUniform);
-        mynydd::uploadUniformData<PrefixParams>(contextPtr, globalPrefixParams, globalPrefixUniform);
-        mynydd::uploadUniformData<PrefixParams>(contextPtr, workgroupPrefixParams, workgroupPrefixUniform);
-        mynydd::uploadUniformData<PrefixParams>(contextPtr, transposeParams, transposeUniform);
-        mynydd::uploadUniformData<SortParams>(contextPtr, sortParams, sortUniform);
+        auto histStep = pass % 2 == 0 ? histPipeline : histPipelinePong;
+        auto sortStep = pass % 2 == 0 ? sortPipeline : sortPipelinePong;
 
-        // // 1) Histogram partial counts
-        mynydd::executeBatch(
-            contextPtr, 
-        {
-                pass % 2 == 0 ? histPipeline : histPipelinePong,
-                sumPipeline,
-                globalPrefixPipeline, 
-                transposePipeline,
-                workgroupPrefixPipeline,
-                pass % 2 == 0 ? sortPipeline : sortPipelinePong
-            }
-        );
+        histStep->pushUniformData(radixParams);
+        histogramScanPipeline->pushUniformData(histogramScanParams);
+        sortStep->pushUniformData(sortParams);
+
+        std::vector<std::shared_ptr<mynydd::PipelineStep>> steps{histStep, histogramScanPipeline};
+        const auto& scanSteps = globalPrefixScan->getSteps();
+        steps.insert(steps.end(), scanSteps.begin(), scanSteps.end());
+        steps.push_back(sortStep);
+        return steps;
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/embedded_shaders.hpp"
+#include "../include/mynydd/pipeline_builder.hpp"
+#include "../include/mynydd/pipelines/scan.hpp"
+
+namespace mynydd {
+
+    namespace {
+        // Must match TILE_ELEMENTS in scan_reduce.comp and scan_tiles.comp
+        const uint32_t tileElements = 1024;
+
+        uint32_t tilesFor(uint32_t count) {
+            return (count + tileElements - 1) / tileElements;
+        }
+    }
+
+    ScanPipeline::ScanPipeline(
+        std::shared_ptr<VulkanContext> contextPtr,
+        std::shared_ptr<Buffer> input,
+        std::shared_ptr<Buffer> output,
+        uint32_t count,
+        const ScanOptions& options
+    ) : contextPtr(contextPtr) {
+        const uint32_t bytes = elementBytes(options.type);
+        if (count == 0) {
+            throw std::runtime_error("Scan needs at least one element");
+        }
+        // Kernels index 32-bit words
+        if (uint64_t(count) * bytes / 4 > UINT32_MAX) {
+            throw std::runtime_error("Scan arrays must be below 16 GiB");
+        }
+        if (input->getSize() < uint64_t(count) * bytes || output->getSize() < uint64_t(count) * bytes) {
+            throw std::runtime_error(
+                "Scan buffers must hold " + std::to_string(count) + " elements of " + std::to_string(bytes) + " bytes"
+            );
+        }
+
+        // Element counts of each level, from the input up to the first that fits one tile
+        std::vector<uint32_t> levelCounts{count};
+        while (levelCounts.back() > tileElements) {
+            levelCounts.push_back(tilesFor(levelCounts.back()));
+        }
+        for (size_t l = 1; l < levelCounts.size(); ++l) {
+            partials.push_back(std::make_shared<Buffer>(contextPtr, size_t(levelCounts[l]) * bytes, false));
+        }
+        const size_t top = partials.size();
+
+        const std::vector<uint32_t> reduceSpirv = getEmbeddedShader("scan_reduce.comp");
+        const std::vector<uint32_t> tilesSpirv = getEmbeddedShader("scan_tiles.comp");
+        const std::vector<uint32_t> pushConstantSizes{sizeof(ScanParams)};
+
+        PipelineBuilder builder(contextPtr);
+        std::vector<ScanParams> params;
+        auto addReduce = [&](std::shared_ptr<Buffer> src, std::shared_ptr<Buffer> dst, uint32_t n) {
+            const std::array<uint32_t, 3> groups = foldGroupCount(contextPtr, tilesFor(n));
+            builder.add(
+                reduceSpirv, "scan_reduce.comp", std::vector<std::shared_ptr<Buffer>>{src, dst},
+                groups[0], groups[1], 1, pushConstantSizes
+            );
+            params.push_back({n, uint32_t(options.type), uint32_t(options.op), 0, 0});
+        };
+        auto addTiles = [&](
+            std::shared_ptr<Buffer> src, std::shared_ptr<Buffer> dst, std::shared_ptr<Buffer> carries,
+            uint32_t n, bool inclusive
+        ) {
+            const std::array<uint32_t, 3> groups = foldGroupCount(contextPtr, tilesFor(n));
+            // Without carries dst stands in for the unused binding
+            builder.add(
+                tilesSpirv, "scan_tiles.comp",
+                std::vector<std::shared_ptr<Buffer>>{src, dst, carries ? carries : dst},
+                groups[0], groups[1], 1, pushConstantSizes
+            );
+            params.push_back({
+                n, uint32_t(options.type), uint32_t(options.op), inclusive ? 1u : 0u, carries ? 1u : 0u
+            });
+        };
+
+        // Reduce every level to the tile sums of the next
+        for (size_t l = 0; l < top; ++l) {
+            addReduce(l == 0 ? input : partials[l - 1], partials[l], levelCounts[l]);
+        }
+        // The top level is a single tile, then each level below takes its carries from
+        // the exclusive scan of the level above
+        if (top > 0) {
+            addTiles(partials[top - 1], partials[top - 1], nullptr, levelCounts[top], false);
+        }
+        for (size_t l = top; l-- > 1;) {
+            addTiles(partials[l - 1], partials[l - 1], partials[l], levelCounts[l], false);
+        }
+        addTiles(input, output, top > 0 ? partials[0] : nullptr, count, options.inclusive);
+
+        steps = builder.build();
+        for (size_t i = 0; i < steps.size(); ++i) {
+            steps[i]->setPushConstantsData(params[i]);
+        }
+    }
+
+    void ScanPipeline::record(VkCommandBuffer cmd) {
+        for (const auto& step : steps) {
+            recordCommandBuffer(cmd, step, true);
+        }
+    }
+
+    void ScanPipeline::execute() {
+        executeBatch(contextPtr, steps);
+    }
+
+}
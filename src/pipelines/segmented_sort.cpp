@@ -0,0 +1,149 @@
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/embedded_shaders.hpp"
+#include "../include/mynydd/pipeline_builder.hpp"
+#include "../include/mynydd/pipelines/radix_sort.hpp"
+#include "../include/mynydd/pipelines/segmented_sort.hpp"
+
+namespace mynydd {
+
+    namespace {
+        // Bits needed to tell apart segment ranks 0..n-1
+        uint32_t rankBits(uint32_t n) {
+            uint32_t bits = 0;
+            while (bits < 32 && (uint64_t(1) << bits) < n) {
+                ++bits;
+            }
+            return bits;
+        }
+    }
+
+    SegmentedSortPipeline::SegmentedSortPipeline(
+        std::shared_ptr<VulkanContext> contextPtr,
+        std::shared_ptr<Buffer> keys,
+        const std::vector<uint32_t>& segmentOffsets
+    ) : contextPtr(contextPtr) {
+        if (segmentOffsets.size() < 2) {
+            throw std::runtime_error("Segmented sort needs at least one segment");
+        }
+        if (segmentOffsets.size() - 1 > UINT32_MAX) {
+            throw std::runtime_error("Segmented sort takes fewer than 2^32 segments");
+        }
+        nSegments = static_cast<uint32_t>(segmentOffsets.size() - 1);
+        const uint32_t count = segmentOffsets.back();
+        if (count == 0) {
+            throw std::runtime_error("Segmented sort needs at least one key");
+        }
+        if (keys->getSize() < uint64_t(count) * sizeof(uint32_t)) {
+            throw std::runtime_error("Keys buffer must hold " + std::to_string(count) + " keys");
+        }
+
+        // Long segments, ranked in input order, and where each starts once gathered
+        std::vector<uint32_t> longOffsets;
+        std::vector<uint32_t> longStarts{0};
+        for (uint32_t s = 0; s < nSegments; ++s) {
+            if (segmentOffsets[s + 1] < segmentOffsets[s]) {
+                throw std::runtime_error("Segment offsets must not decrease, at segment " + std::to_string(s));
+            }
+            const uint32_t len = segmentOffsets[s + 1] - segmentOffsets[s];
+            if (len > localSortCapacity) {
+                longOffsets.push_back(segmentOffsets[s]);
+                longStarts.push_back(longStarts.back() + len);
+            }
+        }
+        nLong = static_cast<uint32_t>(longOffsets.size());
+        nLongKeys = longStarts.back();
+
+        segmentOffsetsBuffer = std::make_shared<Buffer>(contextPtr, segmentOffsets.size() * sizeof(uint32_t), false);
+        uploadData<uint32_t>(contextPtr, segmentOffsets, segmentOffsetsBuffer);
+        sortedKeys = std::make_shared<Buffer>(contextPtr, size_t(count) * sizeof(uint32_t), false);
+        sortedIndices = std::make_shared<Buffer>(contextPtr, size_t(count) * sizeof(uint32_t), false);
+
+        PipelineBuilder builder(contextPtr);
+
+        // One workgroup per segment; long segments return straight away
+        const std::array<uint32_t, 3> segmentGroups = foldGroupCount(contextPtr, nSegments);
+        size_t localIdx = builder.add(
+            getEmbeddedShader("segmented_sort_local.comp"), "segmented_sort_local.comp",
+            std::vector<std::shared_ptr<Buffer>>{keys, segmentOffsetsBuffer, sortedKeys, sortedIndices},
+            segmentGroups[0], segmentGroups[1], 1,
+            std::vector<uint32_t>{sizeof(SegmentedSortParams)}
+        );
+
+        size_t packIdx = SIZE_MAX;
+        size_t unpackIdx = SIZE_MAX;
+        if (nLong > 0) {
+            packedStarts = std::make_shared<Buffer>(contextPtr, longStarts.size() * sizeof(uint32_t), false);
+            longSegmentOffsets = std::make_shared<Buffer>(contextPtr, longOffsets.size() * sizeof(uint32_t), false);
+            uploadData<uint32_t>(contextPtr, longStarts, packedStarts);
+            uploadData<uint32_t>(contextPtr, longOffsets, longSegmentOffsets);
+
+            // The sort carries each key's input position as its payload
+            RadixSortOptions options;
+            options.keyBits = 32 + rankBits(nLong);
+            options.payload = RadixSortPayload::Values;
+            options.payloadBytes = 4;
+            options.keyBytes = 8;
+            longSort = std::make_unique<RadixSortPipeline>(contextPtr, 256, nLongKeys, options);
+
+            const std::array<uint32_t, 3> keyGroups = foldGroupCount(contextPtr, (uint64_t(nLongKeys) + 255) / 256);
+            packIdx = builder.add(
+                getEmbeddedShader("segmented_sort_pack.comp"), "segmented_sort_pack.comp",
+                std::vector<std::shared_ptr<Buffer>>{
+                    keys, packedStarts, longSegmentOffsets, longSort->m_ioBufferA, longSort->getPayloadInputBuffer()
+                },
+                keyGroups[0], keyGroups[1], 1,
+                std::vector<uint32_t>{sizeof(SegmentGatherParams)}
+            );
+            unpackIdx = builder.add(
+                getEmbeddedShader("segmented_sort_unpack.comp"), "segmented_sort_unpack.comp",
+                std::vector<std::shared_ptr<Buffer>>{
+                    longSort->getSortedMortonKeysBuffer(),
+                    longSort->getSortedPayloadBuffer(),
+                    packedStarts,
+                    longSegmentOffsets,
+                    sortedKeys,
+                    sortedIndices
+                },
+                keyGroups[0], keyGroups[1], 1,
+                std::vector<uint32_t>{sizeof(SegmentGatherParams)}
+            );
+        }
+
+        auto steps = builder.build();
+        localSortStep = steps[localIdx];
+        localSortStep->setPushConstantsData(SegmentedSortParams{nSegments});
+        if (nLong > 0) {
+            packStep = steps[packIdx];
+            unpackStep = steps[unpackIdx];
+            packStep->setPushConstantsData(SegmentGatherParams{nLongKeys, nLong});
+            unpackStep->setPushConstantsData(SegmentGatherParams{nLongKeys, nLong});
+        }
+    }
+
+    void SegmentedSortPipeline::record(VkCommandBuffer cmd) {
+        recordCommandBuffer(cmd, localSortStep, true);
+        if (nLong > 0) {
+            recordCommandBuffer(cmd, packStep, true);
+            longSort->record(cmd);
+            recordCommandBuffer(cmd, unpackStep, true);
+        }
+    }
+
+    void SegmentedSortPipeline::execute() {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        if (vkBeginCommandBuffer(contextPtr->commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin command buffer for segmented sort.");
+        }
+        record(contextPtr->commandBuffer);
+        submitAndWait(contextPtr);
+    }
+
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/mynydd/embedded_shaders.hpp"
+#include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/roofline.hpp"
+#include "../include/mynydd/tracer.hpp"
+
+namespace mynydd {
+
+    namespace {
+
+        // Timed runs per probe after one warm-up run; the fastest is kept
+        const int probeRuns = 3;
+        const uint32_t flopsProbeGroups = 1024;
+        const uint32_t flopsProbeIterations = 256;
+        const uint32_t flopsPerIteration = 32; // 16 FMAs, see probe_flops.comp
+
+        // Installs a private tracer for the probes and puts the caller's one back after
+        struct ProbeTracer {
+            std::shared_ptr<VulkanContext> contextPtr;
+            std::shared_ptr<Tracer> saved;
+            std::shared_ptr<Tracer> tracer;
+
+            explicit ProbeTracer(std::shared_ptr<VulkanContext> contextPtr)
+                : contextPtr(contextPtr), saved(contextPtr->tracer) {
+                tracer = enableTracing(contextPtr, 4);
+            }
+            ~ProbeTracer() {
+                contextPtr->tracer = saved;
+            }
+        };
+
+        // Push constants shared by the probe shaders; devbench pushes a larger block
+        // with the same leading fields
+        struct ProbeParams {
+            uint32_t nElements;
+            uint32_t iterations;
+        };
+
+        // Fastest timed run after one warm-up, or 0 when no run had a measurable duration.
+        // A probe that finishes within one timestamp tick gives a zero GPU range, which
+        // says nothing about the peak, so such runs are rejected rather than divided by.
+        double fastestRun(std::shared_ptr<VulkanContext> contextPtr, std::shared_ptr<PipelineStep> step, Tracer& tracer) {
+            double best = 0.0;
+            for (int run = 0; run <= probeRuns; ++run) {
+                tracer.clear();
+                int64_t begin = Tracer::nowNs();
+                executeBatch(contextPtr, {step});
+                int64_t end = Tracer::nowNs();
+
+                // Host time includes submission overhead, so prefer the GPU range
+                double seconds = static_cast<double>(end - begin) * 1e-9;
+                for (const Tracer::Event& event : tracer.getEvents()) {
+                    if (event.category == "gpu") {
+                        seconds = static_cast<double>(event.endNs - event.beginNs) * 1e-9;
+                    }
+                }
+                if (run > 0 && seconds > 0.0 && (best == 0.0 || seconds < best)) {
+                    best = seconds;
+                }
+            }
+            return best;
+        }
+
+    }
+
+    DevicePeaks measureDevicePeaks(std::shared_ptr<VulkanContext> contextPtr, uint64_t probeBytes) {
+        if (!contextPtr || contextPtr->device == VK_NULL_HANDLE) {
+            throw std::runtime_error("Invalid Vulkan context for device peak measurement.");
+        }
+        ProbeTracer probe(contextPtr);
+        DevicePeaks peaks;
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(contextPtr->physicalDevice, &props);
+        uint64_t maxElements = static_cast<uint64_t>(props.limits.maxComputeWorkGroupCount[0]) * 256;
+        uint32_t nElements = static_cast<uint32_t>(std::min<uint64_t>(probeBytes / 16, maxElements));
+        if (nElements == 0) {
+            throw std::runtime_error("Bandwidth probe needs at least 16 bytes.");
+        }
+
+        {
+            VkDeviceSize size = static_cast<VkDeviceSize>(nElements) * 16;
+            auto src = std::make_shared<Buffer>(contextPtr, size, false);
+            auto dst = std::make_shared<Buffer>(contextPtr, size, false);
+            auto copy = std::make_shared<PipelineStep>(
+                contextPtr, getEmbeddedShader("probe_bandwidth.comp"), "probe_bandwidth.comp",
+                std::vector<std::shared_ptr<Buffer>>{src, dst}, 1, 1, 1,
+                std::vector<uint32_t>{sizeof(uint32_t)}
+            );
+            copy->dispatchForElements(nElements);
+            copy->setPushConstantsData(nElements);
+            double seconds = fastestRun(contextPtr, copy, *probe.tracer);
+            if (seconds > 0.0) {
+                peaks.bandwidthGBs = static_cast<double>(2 * size) / seconds * 1e-9;
+            }
+        }
+
+        {
+            uint64_t invocations = static_cast<uint64_t>(flopsProbeGroups) * 256;
+            auto result = std::make_shared<Buffer>(contextPtr, invocations * sizeof(float), false);
+            auto fmas = std::make_shared<PipelineStep>(
+                contextPtr, getEmbeddedShader("probe_flops.comp"), "probe_flops.comp",
+                std::vector<std::shared_ptr<Buffer>>{result}, flopsProbeGroups, 1, 1,
+                std::vector<uint32_t>{sizeof(ProbeParams)}
+            );
+            fmas->setPushConstantsData(ProbeParams{0, flopsProbeIterations});
+            double seconds = fastestRun(contextPtr, fmas, *probe.tracer);
+            if (seconds > 0.0) {
+                double flops = static_cast<double>(invocations) * flopsProbeIterations * flopsPerIteration;
+                peaks.gflops = flops / seconds * 1e-9;
+            }
+        }
+
+        return peaks;
+    }
+
+    std::vector<RooflineEntry> buildRooflineReport(
+        const Tracer& tracer,
+        const std::vector<std::shared_ptr<PipelineStep>>& steps,
+        const DevicePeaks& peaks
+    ) {
+        std::map<std::string, std::pair<uint32_t, int64_t>> timings; // name -> (ranges, total ns)
+        for (const Tracer::Event& event : tracer.getEvents()) {
+            if (event.category == "gpu") {
+                auto& timing = timings[event.name];
+                timing.first += 1;
+                timing.second += event.endNs - event.beginNs;
+            }
+        }
+
+        std::vector<RooflineEntry> entries;
+        for (const auto& step : steps) {
+            auto it = timings.find(step->getName());
+            if (it == timings.end() || it->second.first == 0) {
+                continue;
+            }
+            bool seen = std::any_of(entries.begin(), entries.end(), [&](const RooflineEntry& e) {
+                return e.name == step->getName();
+            });
+            if (seen) {
+                continue;
+            }
+
+            RooflineEntry entry;
+            entry.name = step->getName();
+            entry.model = step->getWorkloadModel();
+            entry.dispatches = it->second.first;
+            entry.meanSeconds = static_cast<double>(it->second.second) * 1e-9 / entry.dispatches;
+            if (entry.meanSeconds > 0.0) {
+                entry.achievedGBs = static_cast<double>(entry.model.bytesMoved()) / entry.meanSeconds * 1e-9;
+                entry.achievedGFlops = static_cast<double>(entry.model.ops) / entry.meanSeconds * 1e-9;
+            }
+            if (peaks.bandwidthGBs > 0.0) {
+                entry.bandwidthFraction = entry.achievedGBs / peaks.bandwidthGBs;
+            }
+            if (peaks.gflops > 0.0) {
+                entry.computeFraction = entry.achievedGFlops / peaks.gflops;
+            }
+            if (peaks.ridgeIntensity() > 0.0) {
+                entry.memoryBound = entry.model.intensity() < peaks.ridgeIntensity();
+            }
+            entries.push_back(entry);
+        }
+        return entries;
+    }
+
+    void printRooflineReport(std::ostream& os, const std::vector<RooflineEntry>& entries, const DevicePeaks& peaks) {
+        std::ios_base::fmtflags flags = os.flags();
+        os << std::fixed << std::setprecision(2);
+        os << "Device peaks: ";
+        if (peaks.bandwidthGBs > 0.0) {
+            os << peaks.bandwidthGBs << " GB/s, ";
+        } else {
+            os << "bandwidth unavailable, ";
+        }
+        if (peaks.gflops > 0.0) {
+            os << peaks.gflops << " GFLOP/s, ";
+        } else {
+            os << "compute unavailable, ";
+        }
+        if (peaks.ridgeIntensity() > 0.0) {
+            os << "ridge at " << peaks.ridgeIntensity() << " ops/byte" << std::endl;
+        } else {
+            os << "ridge unknown" << std::endl;
+        }
+        for (const RooflineEntry& e : entries) {
+            os << e.name << ": " << e.dispatches << " dispatches, mean " << e.meanSeconds * 1e3 << " ms, "
+               << e.achievedGBs << " GB/s (" << e.bandwidthFraction * 100.0 << "% of peak), "
+               << e.achievedGFlops << " GFLOP/s (" << e.computeFraction * 100.0 << "% of peak), "
+               << e.model.intensity() << " ops/byte, " << (e.memoryBound ? "memory" : "compute") << " bound"
+               << std::endl;
+        }
+        os.flags(flags);
+    }
+
+}
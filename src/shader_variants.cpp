@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef MYNYDD_WITH_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+#include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/shader_variants.hpp"
+
+namespace fs = std::filesystem;
+
+namespace mynydd {
+
+    namespace {
+
+        // Bump when the compile options change, so stale binaries are not reused
+        const char* variantCacheVersion = "mynydd-variant-v1";
+
+        std::string readTextFile(const fs::path& path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open shader source: " + path.string());
+            }
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // Resolves an #include the way the compiler will: next to the includer, then in includeDirs
+        fs::path resolveInclude(
+            const std::string& requested,
+            const fs::path& includer,
+            const std::vector<std::string>& includeDirs
+        ) {
+            fs::path local = includer.parent_path() / requested;
+            if (fs::exists(local)) {
+                return local;
+            }
+            for (const auto& dir : includeDirs) {
+                fs::path candidate = fs::path(dir) / requested;
+                if (fs::exists(candidate)) {
+                    return candidate;
+                }
+            }
+            return {};
+        }
+
+        // Collects the text of a file and everything it includes, depth first
+        void collectSources(
+            const fs::path& path,
+            const std::vector<std::string>& includeDirs,
+            std::set<std::string>& visited,
+            std::string& out
+        ) {
+            std::string canonical = fs::weakly_canonical(path).string();
+            if (!visited.insert(canonical).second) {
+                return;
+            }
+            std::string text = readTextFile(path);
+            out += text;
+            out.push_back('\0');
+
+            std::istringstream lines(text);
+            std::string line;
+            while (std::getline(lines, line)) {
+                size_t hash = line.find_first_not_of(" \t");
+                if (hash == std::string::npos || line.compare(hash, 8, "#include") != 0) {
+                    continue;
+                }
+                size_t open = line.find_first_of("\"<", hash + 8);
+                if (open == std::string::npos) {
+                    continue;
+                }
+                size_t close = line.find_first_of("\">", open + 1);
+                if (close == std::string::npos) {
+                    continue;
+                }
+                fs::path included = resolveInclude(line.substr(open + 1, close - open - 1), path, includeDirs);
+                if (!included.empty()) {
+                    collectSources(included, includeDirs, visited, out);
+                }
+            }
+        }
+
+        uint64_t fnv1a(const std::string& data, uint64_t hash = 0xcbf29ce484222325ull) {
+            for (unsigned char c : data) {
+                hash ^= c;
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+#ifdef MYNYDD_WITH_SHADERC
+        class FileIncluder : public shaderc::CompileOptions::IncluderInterface {
+            public:
+                explicit FileIncluder(std::vector<std::string> includeDirs) : includeDirs(std::move(includeDirs)) {}
+
+                shaderc_include_result* GetInclude(
+                    const char* requestedSource,
+                    shaderc_include_type,
+                    const char* requestingSource,
+                    size_t
+                ) override {
+                    auto data = std::make_unique<IncludeData>();
+                    fs::path resolved = resolveInclude(requestedSource, requestingSource, includeDirs);
+                    if (resolved.empty()) {
+                        // An empty source name tells shaderc the include failed
+                        data->content = std::string("Cannot find include ") + requestedSource;
+                    } else {
+                        data->name = resolved.string();
+                        data->content = readTextFile(resolved);
+                    }
+                    data->result.source_name = data->name.c_str();
+                    data->result.source_name_length = data->name.size();
+                    data->result.content = data->content.c_str();
+                    data->result.content_length = data->content.size();
+                    data->result.user_data = data.get();
+                    return &data.release()->result;
+                }
+
+                void ReleaseInclude(shaderc_include_result* result) override {
+                    delete static_cast<IncludeData*>(result->user_data);
+                }
+
+            private:
+                struct IncludeData {
+                    std::string name;
+                    std::string content;
+                    shaderc_include_result result;
+                };
+                std::vector<std::string> includeDirs;
+        };
+#endif
+
+    }
+
+    std::string shaderVariantKey(
+        const std::string& sourcePath,
+        const ShaderDefines& defines,
+        const std::vector<std::string>& includeDirs
+    ) {
+        std::string content = variantCacheVersion;
+        content.push_back('\0');
+
+        std::set<std::string> visited;
+        collectSources(sourcePath, includeDirs, visited, content);
+
+        ShaderDefines sorted = defines;
+        std::sort(sorted.begin(), sorted.end());
+        for (const auto& [name, value] : sorted) {
+            content += name + "=" + value;
+            content.push_back('\0');
+        }
+
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(fnv1a(content)));
+        return hex;
+    }
+
+    std::string shaderVariantCachePath(
+        const std::string& sourcePath,
+        const ShaderDefines& defines,
+        const std::string& cacheDir,
+        const std::vector<std::string>& includeDirs
+    ) {
+        std::string stem = fs::path(sourcePath).filename().string();
+        return (fs::path(cacheDir) / (stem + "." + shaderVariantKey(sourcePath, defines, includeDirs) + ".spv")).string();
+    }
+
+    bool shaderCompilerAvailable() {
+#ifdef MYNYDD_WITH_SHADERC
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::vector<uint32_t> compileShaderVariant(
+        const std::string& sourcePath,
+        const ShaderDefines& defines,
+        const std::string& cacheDir,
+        const std::vector<std::string>& includeDirs
+    ) {
+        std::string cachePath = shaderVariantCachePath(sourcePath, defines, cacheDir, includeDirs);
+        if (fs::exists(cachePath)) {
+            return readShaderFile(cachePath.c_str());
+        }
+
+#ifdef MYNYDD_WITH_SHADERC
+        shaderc::Compiler compiler;
+        shaderc::CompileOptions options;
+        for (const auto& [name, value] : defines) {
+            options.AddMacroDefinition(name, value);
+        }
+        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+        options.SetOptimizationLevel(shaderc_optimization_level_performance);
+        options.SetIncluder(std::make_unique<FileIncluder>(includeDirs));
+
+        std::string source = readTextFile(sourcePath);
+        shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
+            source, shaderc_compute_shader, sourcePath.c_str(), options
+        );
+        if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+            throw std::runtime_error("Failed to compile " + sourcePath + ":\n" + result.GetErrorMessage());
+        }
+        std::vector<uint32_t> spirv(result.cbegin(), result.cend());
+
+        // Write to a temporary name first so concurrent processes never read a partial file
+        fs::create_directories(cacheDir);
+        std::string tmpPath = cachePath + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to write shader cache file: " + tmpPath);
+            }
+            file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+        }
+        fs::rename(tmpPath, cachePath);
+        return spirv;
+#else
+        throw std::runtime_error(
+            "Shader variant " + cachePath + " is not cached and mynydd was built without "
+            "MYNYDD_WITH_SHADERC, so it cannot be compiled at runtime"
+        );
+#endif
+    }
+
+}
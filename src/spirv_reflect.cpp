@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/mynydd/spirv_reflect.hpp"
+
+namespace mynydd {
+
+    // Subset of the SPIR-V specification used below
+    namespace spv {
+        const uint32_t MagicNumber = 0x07230203;
+
+        const uint32_t OpEntryPoint = 15;
+        const uint32_t OpExecutionMode = 16;
+        const uint32_t OpCapability = 17;
+        const uint32_t OpTypeInt = 21;
+        const uint32_t OpTypeFloat = 22;
+        const uint32_t OpTypeVector = 23;
+        const uint32_t OpTypeMatrix = 24;
+        const uint32_t OpTypeArray = 28;
+        const uint32_t OpTypeRuntimeArray = 29;
+        const uint32_t OpTypeStruct = 30;
+        const uint32_t OpTypePointer = 32;
+        const uint32_t OpConstant = 43;
+        const uint32_t OpConstantComposite = 44;
+        const uint32_t OpSpecConstant = 50;
+        const uint32_t OpSpecConstantComposite = 51;
+        const uint32_t OpVariable = 59;
+        const uint32_t OpDecorate = 71;
+        const uint32_t OpMemberDecorate = 72;
+        const uint32_t OpExecutionModeId = 331;
+
+        const uint32_t ExecutionModeLocalSize = 17;
+        const uint32_t ExecutionModeLocalSizeId = 38;
+
+        const uint32_t DecorationBlock = 2;
+        const uint32_t DecorationBufferBlock = 3;
+        const uint32_t DecorationArrayStride = 6;
+        const uint32_t DecorationBuiltIn = 11;
+        const uint32_t DecorationNonWritable = 24;
+        const uint32_t DecorationNonReadable = 25;
+        const uint32_t DecorationBinding = 33;
+        const uint32_t DecorationDescriptorSet = 34;
+        const uint32_t DecorationOffset = 35;
+
+        const uint32_t BuiltInWorkgroupSize = 25;
+
+        const uint32_t StorageClassUniform = 2;
+        const uint32_t StorageClassPushConstant = 9;
+        const uint32_t StorageClassStorageBuffer = 12;
+        const uint32_t StorageClassPhysicalStorageBuffer = 5349;
+
+        const uint32_t CapabilityPhysicalStorageBufferAddresses = 5347;
+    }
+
+    namespace {
+
+        struct TypeInfo {
+            uint32_t opcode = 0;
+            std::vector<uint32_t> operands; // words after the result id
+        };
+
+        struct Decorations {
+            bool block = false;
+            bool bufferBlock = false;
+            bool nonWritable = false;
+            bool nonReadable = false;
+            bool workgroupSize = false;
+            uint32_t binding = UINT32_MAX;
+            uint32_t set = 0;
+            uint32_t arrayStride = 0;
+        };
+
+        struct MemberDecorations {
+            bool nonWritable = false;
+            bool nonReadable = false;
+            uint32_t offset = 0;
+        };
+
+        struct Module {
+            std::map<uint32_t, TypeInfo> types;
+            std::map<uint32_t, uint32_t> constants; // 32-bit scalar constants
+            std::map<uint32_t, std::vector<uint32_t>> composites;
+            std::map<uint32_t, Decorations> decorations;
+            std::map<uint32_t, std::map<uint32_t, MemberDecorations>> memberDecorations;
+
+            uint32_t typeSize(uint32_t id) const {
+                auto it = types.find(id);
+                if (it == types.end()) {
+                    throw std::runtime_error("SPIR-V reflection: unknown type id " + std::to_string(id));
+                }
+                const TypeInfo& t = it->second;
+                switch (t.opcode) {
+                    case spv::OpTypeInt:
+                    case spv::OpTypeFloat:
+                        return t.operands[0] / 8;
+                    case spv::OpTypeVector:
+                    case spv::OpTypeMatrix:
+                        return t.operands[1] * typeSize(t.operands[0]);
+                    case spv::OpTypeArray: {
+                        uint32_t length = constants.at(t.operands[1]);
+                        auto d = decorations.find(id);
+                        uint32_t stride = (d != decorations.end() && d->second.arrayStride != 0)
+                            ? d->second.arrayStride : typeSize(t.operands[0]);
+                        return length * stride;
+                    }
+                    case spv::OpTypeRuntimeArray:
+                        return 0;
+                    case spv::OpTypePointer:
+                        return 8; // only physical storage buffer pointers appear inside blocks
+                    case spv::OpTypeStruct: {
+                        uint32_t size = 0;
+                        auto md = memberDecorations.find(id);
+                        for (uint32_t m = 0; m < t.operands.size(); ++m) {
+                            uint32_t offset = 0;
+                            if (md != memberDecorations.end() && md->second.count(m)) {
+                                offset = md->second.at(m).offset;
+                            }
+                            size = std::max(size, offset + typeSize(t.operands[m]));
+                        }
+                        return size;
+                    }
+                    default:
+                        throw std::runtime_error(
+                            "SPIR-V reflection: cannot size type with opcode " + std::to_string(t.opcode)
+                        );
+                }
+            }
+        };
+
+    }
+
+    ShaderReflection reflectSpirv(const std::vector<uint32_t>& code) {
+        if (code.size() < 5 || code[0] != spv::MagicNumber) {
+            throw std::runtime_error("SPIR-V reflection: not a SPIR-V module");
+        }
+
+        ShaderReflection reflection;
+        Module module;
+        std::vector<uint32_t> localSizeIds;
+        struct Variable { uint32_t typeId; uint32_t id; uint32_t storageClass; };
+        std::vector<Variable> variables;
+
+        size_t i = 5;
+        while (i < code.size()) {
+            uint32_t wordCount = code[i] >> 16;
+            uint32_t opcode = code[i] & 0xFFFF;
+            if (wordCount == 0 || i + wordCount > code.size()) {
+                throw std::runtime_error("SPIR-V reflection: malformed instruction stream");
+            }
+            const uint32_t* w = &code[i];
+
+            switch (opcode) {
+                case spv::OpCapability:
+                    if (w[1] == spv::CapabilityPhysicalStorageBufferAddresses) {
+                        reflection.usesBufferDeviceAddress = true;
+                    }
+                    break;
+                case spv::OpExecutionMode:
+                case spv::OpExecutionModeId:
+                    if (w[2] == spv::ExecutionModeLocalSize && wordCount >= 6) {
+                        reflection.localSize = {w[3], w[4], w[5]};
+                    } else if (w[2] == spv::ExecutionModeLocalSizeId && wordCount >= 6) {
+                        localSizeIds = {w[3], w[4], w[5]};
+                    }
+                    break;
+                case spv::OpTypeInt:
+                case spv::OpTypeFloat:
+                case spv::OpTypeVector:
+                case spv::OpTypeMatrix:
+                case spv::OpTypeArray:
+                case spv::OpTypeRuntimeArray:
+                case spv::OpTypeStruct:
+                case spv::OpTypePointer:
+                    module.types[w[1]] = TypeInfo{opcode, std::vector<uint32_t>(w + 2, w + wordCount)};
+                    break;
+                case spv::OpConstant:
+                case spv::OpSpecConstant:
+                    if (wordCount >= 4) {
+                        module.constants[w[2]] = w[3];
+                    }
+                    break;
+                case spv::OpConstantComposite:
+                case spv::OpSpecConstantComposite:
+                    module.composites[w[2]] = std::vector<uint32_t>(w + 3, w + wordCount);
+                    break;
+                case spv::OpVariable:
+                    variables.push_back({w[1], w[2], w[3]});
+                    break;
+                case spv::OpDecorate: {
+                    Decorations& d = module.decorations[w[1]];
+                    switch (w[2]) {
+                        case spv::DecorationBlock: d.block = true; break;
+                        case spv::DecorationBufferBlock: d.bufferBlock = true; break;
+                        case spv::DecorationNonWritable: d.nonWritable = true; break;
+                        case spv::DecorationNonReadable: d.nonReadable = true; break;
+                        case spv::DecorationBinding: d.binding = w[3]; break;
+                        case spv::DecorationDescriptorSet: d.set = w[3]; break;
+                        case spv::DecorationArrayStride: d.arrayStride = w[3]; break;
+                        case spv::DecorationBuiltIn:
+                            d.workgroupSize = w[3] == spv::BuiltInWorkgroupSize;
+                            break;
+                        default: break;
+                    }
+                    break;
+                }
+                case spv::OpMemberDecorate: {
+                    MemberDecorations& d = module.memberDecorations[w[1]][w[2]];
+                    switch (w[3]) {
+                        case spv::DecorationNonWritable: d.nonWritable = true; break;
+                        case spv::DecorationNonReadable: d.nonReadable = true; break;
+                        case spv::DecorationOffset: d.offset = w[4]; break;
+                        default: break;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            i += wordCount;
+        }
+
+        // A WorkgroupSize built-in, if present, takes precedence over the execution mode
+        if (!localSizeIds.empty()) {
+            for (size_t k = 0; k < 3; ++k) {
+                reflection.localSize[k] = module.constants.at(localSizeIds[k]);
+            }
+        }
+        for (const auto& [id, d] : module.decorations) {
+            if (d.workgroupSize && module.composites.count(id)) {
+                const auto& components = module.composites.at(id);
+                for (size_t k = 0; k < 3 && k < components.size(); ++k) {
+                    reflection.localSize[k] = module.constants.at(components[k]);
+                }
+            }
+        }
+
+        for (const Variable& v : variables) {
+            const TypeInfo& pointer = module.types.at(v.typeId);
+            uint32_t pointee = pointer.operands[1];
+
+            if (v.storageClass == spv::StorageClassPushConstant) {
+                reflection.pushConstantSize = module.typeSize(pointee);
+                continue;
+            }
+            if (v.storageClass != spv::StorageClassUniform && v.storageClass != spv::StorageClassStorageBuffer) {
+                continue;
+            }
+
+            // Arrays of blocks become descriptor arrays
+            uint32_t count = 1;
+            uint32_t blockType = pointee;
+            const TypeInfo& pointeeType = module.types.at(pointee);
+            if (pointeeType.opcode == spv::OpTypeArray) {
+                count = module.constants.at(pointeeType.operands[1]);
+                blockType = pointeeType.operands[0];
+            }
+
+            const Decorations& blockDecorations = module.decorations[blockType];
+            const Decorations& varDecorations = module.decorations[v.id];
+
+            ReflectedBinding binding;
+            binding.set = varDecorations.set;
+            binding.binding = varDecorations.binding;
+            binding.descriptorCount = count;
+            bool storage = v.storageClass == spv::StorageClassStorageBuffer || blockDecorations.bufferBlock;
+            binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+            if (storage) {
+                const TypeInfo& block = module.types.at(blockType);
+                const auto& members = module.memberDecorations[blockType];
+                bool allNonWritable = !block.operands.empty();
+                bool allNonReadable = !block.operands.empty();
+                for (uint32_t m = 0; m < block.operands.size(); ++m) {
+                    auto it = members.find(m);
+                    allNonWritable = allNonWritable && it != members.end() && it->second.nonWritable;
+                    allNonReadable = allNonReadable && it != members.end() && it->second.nonReadable;
+                }
+                binding.readOnly = varDecorations.nonWritable || allNonWritable;
+                binding.writeOnly = varDecorations.nonReadable || allNonReadable;
+            } else {
+                binding.readOnly = true;
+            }
+            reflection.bindings.push_back(binding);
+        }
+
+        std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& a, const auto& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+        return reflection;
+    }
+
+    void validateShaderInterface(
+        const ShaderReflection& reflection,
+        const std::vector<std::shared_ptr<Buffer>>& buffers,
+        const std::vector<uint32_t>& pushConstantSizes,
+        const std::string& shaderName
+    ) {
+        for (const auto& b : reflection.bindings) {
+            std::string where = shaderName + " (set " + std::to_string(b.set) + ", binding " + std::to_string(b.binding) + ")";
+            if (b.set != 0) {
+                throw std::runtime_error("Only descriptor set 0 is supported: " + where);
+            }
+            if (b.descriptorCount != 1) {
+                throw std::runtime_error("Descriptor arrays are not supported: " + where);
+            }
+            if (b.binding >= buffers.size()) {
+                throw std::runtime_error(
+                    "No buffer provided for " + where + "; got " + std::to_string(buffers.size()) + " buffers"
+                );
+            }
+            VkDescriptorType provided = buffers[b.binding]->getType();
+            bool providedUniform = provided == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                || provided == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            bool expectedUniform = b.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            if (providedUniform != expectedUniform) {
+                throw std::runtime_error(
+                    std::string("Shader expects a ") + (expectedUniform ? "uniform" : "storage") +
+                    " buffer but a " + (providedUniform ? "uniform" : "storage") + " buffer was provided for " + where
+                );
+            }
+        }
+
+        uint32_t provided = std::accumulate(pushConstantSizes.begin(), pushConstantSizes.end(), 0u);
+        if (provided < reflection.pushConstantSize) {
+            throw std::runtime_error(
+                shaderName + " uses " + std::to_string(reflection.pushConstantSize) +
+                " bytes of push constants but only " + std::to_string(provided) + " were declared"
+            );
+        }
+    }
+
+}
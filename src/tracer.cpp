@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan_core.h>
+
+#include "../include/mynydd/mynydd.hpp"
+#include "../include/mynydd/tracer.hpp"
+
+namespace mynydd {
+
+    namespace {
+
+        // Empty submissions used to line up the GPU and host clocks; the tightest one wins
+        const int calibrationRounds = 5;
+
+        std::string jsonEscape(const std::string& text) {
+            std::string out;
+            out.reserve(text.size());
+            for (char c : text) {
+                switch (c) {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char buf[8];
+                            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                            out += buf;
+                        } else {
+                            out.push_back(c);
+                        }
+                }
+            }
+            return out;
+        }
+
+        std::string microseconds(int64_t ns) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3f", static_cast<double>(ns) / 1000.0);
+            return buf;
+        }
+
+    }
+
+    Tracer::Tracer(
+        VkPhysicalDevice physicalDevice,
+        VkDevice device,
+        VkQueue queue,
+        uint32_t queueFamilyIndex,
+        VkCommandPool commandPool,
+        uint32_t maxGpuRanges
+    ) : device(device), maxGpuRanges(maxGpuRanges) {
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+        uint32_t validBits = queueFamilyIndex < familyCount ? families[queueFamilyIndex].timestampValidBits : 0;
+        if (validBits == 0 || maxGpuRanges == 0) {
+            return; // host events only
+        }
+        timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        timestampPeriodNs = props.limits.timestampPeriod;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = 2 * maxGpuRanges;
+        if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create timestamp query pool for tracer.");
+        }
+
+        VkCommandBuffer cmd = allocateCommandBuffer(device, commandPool);
+        VkFence fence;
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+            vkFreeCommandBuffers(device, commandPool, 1, &cmd);
+            vkDestroyQueryPool(device, queryPool, nullptr);
+            throw std::runtime_error("Failed to create fence for tracer calibration.");
+        }
+
+        // The timestamp lands somewhere between submit and fence signal; take the
+        // midpoint of the narrowest window as the host time it was written
+        int64_t bestWindow = std::numeric_limits<int64_t>::max();
+        for (int round = 0; round < calibrationRounds; ++round) {
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(cmd, &beginInfo);
+            vkCmdResetQueryPool(cmd, queryPool, 0, 1);
+            vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+            vkEndCommandBuffer(cmd);
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &cmd;
+
+            int64_t before = nowNs();
+            if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+                break;
+            }
+            vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+            int64_t after = nowNs();
+            vkResetFences(device, 1, &fence);
+
+            uint64_t ticks = 0;
+            if (vkGetQueryPoolResults(
+                    device, queryPool, 0, 1, sizeof(ticks), &ticks, sizeof(ticks), VK_QUERY_RESULT_64_BIT
+                ) != VK_SUCCESS) {
+                continue;
+            }
+            if (after - before < bestWindow) {
+                bestWindow = after - before;
+                int64_t gpuNs = static_cast<int64_t>(static_cast<double>(ticks & timestampMask) * timestampPeriodNs);
+                gpuOffsetNs = before + (after - before) / 2 - gpuNs;
+            }
+        }
+        vkDestroyFence(device, fence, nullptr);
+        vkFreeCommandBuffers(device, commandPool, 1, &cmd);
+
+        if (bestWindow == std::numeric_limits<int64_t>::max()) {
+            vkDestroyQueryPool(device, queryPool, nullptr);
+            queryPool = VK_NULL_HANDLE;
+        }
+    }
+
+    Tracer::~Tracer() {
+        if (queryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(device, queryPool, nullptr);
+        }
+    }
+
+    uint32_t Tracer::hostTrack() {
+        auto id = std::this_thread::get_id();
+        auto it = hostTracks.find(id);
+        if (it == hostTracks.end()) {
+            it = hostTracks.emplace(id, static_cast<uint32_t>(hostTracks.size() + 1)).first;
+        }
+        return it->second;
+    }
+
+    void Tracer::hostEvent(const std::string& name, int64_t beginNs, int64_t endNs) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back({name, "host", beginNs, endNs, hostTrack()});
+    }
+
+    bool Tracer::beginGpuRange(VkCommandBuffer cmd, const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queryPool == VK_NULL_HANDLE || pendingGpuNames.size() >= maxGpuRanges) {
+            return false;
+        }
+        uint32_t first = 2 * static_cast<uint32_t>(pendingGpuNames.size());
+        vkCmdResetQueryPool(cmd, queryPool, first, 2);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, first);
+        pendingGpuNames.push_back(name);
+        gpuRangeOpen = true;
+        return true;
+    }
+
+    void Tracer::endGpuRange(VkCommandBuffer cmd) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!gpuRangeOpen) {
+            return;
+        }
+        uint32_t last = 2 * static_cast<uint32_t>(pendingGpuNames.size()) - 1;
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, last);
+        gpuRangeOpen = false;
+    }
+
+    void Tracer::resolveGpuRanges() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pendingGpuNames.empty()) {
+            return;
+        }
+        uint32_t queryCount = 2 * static_cast<uint32_t>(pendingGpuNames.size());
+
+        // Value and availability per query; ranges recorded into a command buffer that
+        // was never submitted stay unavailable and are dropped instead of blocking here
+        std::vector<uint64_t> results(2 * queryCount, 0);
+        VkResult result = vkGetQueryPoolResults(
+            device, queryPool, 0, queryCount,
+            results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+        );
+        if (result == VK_SUCCESS || result == VK_NOT_READY) {
+            for (size_t i = 0; i < pendingGpuNames.size(); ++i) {
+                const uint64_t* begin = &results[4 * i];
+                const uint64_t* end = &results[4 * i + 2];
+                if (begin[1] == 0 || end[1] == 0) {
+                    continue;
+                }
+                uint64_t startTicks = begin[0] & timestampMask;
+                uint64_t elapsedTicks = (end[0] - begin[0]) & timestampMask;
+                int64_t beginNs = static_cast<int64_t>(static_cast<double>(startTicks) * timestampPeriodNs) + gpuOffsetNs;
+                int64_t durationNs = static_cast<int64_t>(static_cast<double>(elapsedTicks) * timestampPeriodNs);
+                events.push_back({pendingGpuNames[i], "gpu", beginNs, beginNs + durationNs, 0});
+            }
+        }
+        pendingGpuNames.clear();
+        gpuRangeOpen = false;
+    }
+
+    std::vector<Tracer::Event> Tracer::getEvents() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return events;
+    }
+
+    void Tracer::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.clear();
+    }
+
+    std::string Tracer::toChromeTraceJson() const {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Timestamps are relative to the first event so they stay readable in the viewer
+        int64_t origin = 0;
+        if (!events.empty()) {
+            origin = std::min_element(events.begin(), events.end(), [](const Event& a, const Event& b) {
+                return a.beginNs < b.beginNs;
+            })->beginNs;
+        }
+
+        std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"mynydd\"}},\n";
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+        for (const auto& [id, track] : hostTracks) {
+            json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(track) +
+                ",\"args\":{\"name\":\"host thread " + std::to_string(track) + "\"}}";
+        }
+        for (const Event& event : events) {
+            json += ",\n{\"name\":\"" + jsonEscape(event.name) +
+                "\",\"cat\":\"" + event.category +
+                "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(event.track) +
+                ",\"ts\":" + microseconds(event.beginNs - origin) +
+                ",\"dur\":" + microseconds(event.endNs - event.beginNs) + "}";
+        }
+        json += "\n]}\n";
+        return json;
+    }
+
+    void Tracer::writeChromeTrace(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open trace file for writing: " + path);
+        }
+        file << toChromeTraceJson();
+    }
+
+    std::shared_ptr<Tracer> enableTracing(std::shared_ptr<VulkanContext> contextPtr, uint32_t maxGpuRanges) {
+        if (!contextPtr || contextPtr->device == VK_NULL_HANDLE) {
+            throw std::runtime_error("Invalid Vulkan context for tracing.");
+        }
+        contextPtr->tracer.reset(); // release the old query pool before creating a new one
+        contextPtr->tracer = std::make_shared<Tracer>(
+            contextPtr->physicalDevice,
+            contextPtr->device,
+            contextPtr->computeQueue,
+            contextPtr->computeQueueFamilyIndex,
+            contextPtr->commandPool,
+            maxGpuRanges
+        );
+        return contextPtr->tracer;
+    }
+
+}
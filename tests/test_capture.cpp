@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <mynydd/capture.hpp>
+#include <mynydd/mynydd.hpp>
+
+TEST_CASE("A captured batch replays to the same result on a new context", "[capture]") {
+    const std::string capturePath = (std::filesystem::temp_directory_path() / "mynydd_capture_test.bin").string();
+    std::filesystem::remove(capturePath); // a leftover file must not stand in for a failed capture
+    uint32_t n = 512;
+    std::vector<uint32_t> expected;
+    {
+        auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+        auto a = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+        auto b = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+        auto c = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+        std::vector<uint32_t> input(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            input[i] = i;
+        }
+        mynydd::uploadData<uint32_t>(contextPtr, input, b);
+
+        auto fill = std::make_shared<mynydd::PipelineStep>(
+            contextPtr, "shaders/push_constants.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{a},
+            n / 256, 1, 1,
+            std::vector<uint32_t>{sizeof(uint32_t)}
+        );
+        fill->setPushConstantsData(uint32_t(7));
+        auto add = std::make_shared<mynydd::PipelineStep>(
+            contextPtr, "shaders/graph_add.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{a, b, c},
+            n / 256
+        );
+
+        mynydd::captureNextBatch(contextPtr, capturePath);
+        mynydd::executeBatch(contextPtr, {fill, add});
+        REQUIRE(contextPtr->capturePath.empty()); // only the one batch is captured
+        expected = mynydd::fetchData<uint32_t>(contextPtr, c, n);
+        REQUIRE(expected[5] == 12);
+    }
+
+    mynydd::BatchCapture capture = mynydd::readCapture(capturePath);
+    std::filesystem::remove(capturePath);
+    REQUIRE(capture.buffers.size() == 3); // a is shared by both steps
+    REQUIRE(capture.steps.size() == 2);
+    REQUIRE(capture.steps[0].name == "shaders/push_constants.comp.spv");
+    REQUIRE(capture.steps[0].pushConstants.size() == sizeof(uint32_t));
+    REQUIRE(capture.steps[1].buffers == std::vector<uint32_t>{0, 1, 2});
+    REQUIRE(capture.steps[1].groupCount[0] == n / 256);
+    REQUIRE(!capture.externalCommands);
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    mynydd::ReplayBatch replay = mynydd::instantiateCapture(contextPtr, capture);
+    mynydd::executeBatch(contextPtr, replay.steps);
+    REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, replay.buffers[2], n) == expected);
+
+    // Restoring puts the inputs back as they were before the captured batch ran
+    mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(n, 0), replay.buffers[1]);
+    mynydd::restoreCaptureBuffers(contextPtr, capture, replay);
+    mynydd::executeBatch(contextPtr, replay.steps);
+    REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, replay.buffers[2], n) == expected);
+}
+
+
+TEST_CASE("A step reading the uniform ring at a dynamic offset replays the same", "[capture]") {
+    struct RingParams {
+        float val;
+        float _pad[3];
+    };
+
+    const std::string capturePath = (std::filesystem::temp_directory_path() / "mynydd_capture_ring_test.bin").string();
+    std::filesystem::remove(capturePath);
+    uint32_t n = 256;
+    std::vector<uint32_t> dynamicOffsets;
+    {
+        auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+        auto data = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+        mynydd::uploadData<float>(contextPtr, std::vector<float>(n, 1.0f), data);
+        auto step = std::make_shared<mynydd::PipelineStep>(
+            contextPtr, "shaders/shader_uniform_dynamic.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{data, mynydd::getUniformRing(contextPtr)->getBuffer()},
+            n / 64
+        );
+
+        // The second push lands past the first block, so the step reads a non-zero offset
+        step->pushUniformData(RingParams{2.0f});
+        step->pushUniformData(RingParams{5.0f});
+        dynamicOffsets = step->getDynamicOffsets();
+        REQUIRE(dynamicOffsets[0] > 0);
+
+        mynydd::captureNextBatch(contextPtr, capturePath);
+        mynydd::executeBatch(contextPtr, {step});
+        REQUIRE(mynydd::fetchData<float>(contextPtr, data, n)[0] == 6.0f);
+    }
+
+    mynydd::BatchCapture capture = mynydd::readCapture(capturePath);
+    std::filesystem::remove(capturePath);
+    REQUIRE(capture.buffers.size() == 2);
+    REQUIRE(capture.buffers[1].type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+    REQUIRE(capture.steps[0].dynamicOffsets == dynamicOffsets);
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    mynydd::ReplayBatch replay = mynydd::instantiateCapture(contextPtr, capture);
+    mynydd::executeBatch(contextPtr, replay.steps);
+    REQUIRE(mynydd::fetchData<float>(contextPtr, replay.buffers[0], n) == std::vector<float>(n, 6.0f));
+}
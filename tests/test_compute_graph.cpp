@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/compute_graph.hpp>
+
+static std::shared_ptr<mynydd::PipelineStep> makeFillStep(
+    std::shared_ptr<mynydd::VulkanContext> contextPtr,
+    std::shared_ptr<mynydd::Buffer> buffer,
+    uint32_t value,
+    uint32_t groupCount
+) {
+    auto step = std::make_shared<mynydd::PipelineStep>(
+        contextPtr,
+        "shaders/push_constants.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{buffer},
+        groupCount, 1, 1,
+        std::vector<uint32_t>{sizeof(uint32_t)}
+    );
+    step->setPushConstantsData(value);
+    return step;
+}
+
+TEST_CASE("Compute graph runs independent branches and joins them", "[graph]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    REQUIRE(!contextPtr->computeQueues.empty());
+    REQUIRE(contextPtr->computeQueues[0] == contextPtr->computeQueue);
+
+    uint32_t n = 512;
+    uint32_t groupCount = n / 256;
+    auto a = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto b = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto c = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+
+    auto fillA = makeFillStep(contextPtr, a, 3, groupCount);
+    auto fillB = makeFillStep(contextPtr, b, 5, groupCount);
+    auto add = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/graph_add.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{a, b, c},
+        groupCount
+    );
+    auto refillA = makeFillStep(contextPtr, a, 11, groupCount);
+
+    mynydd::ComputeGraph graph(contextPtr);
+    size_t nodeA = graph.addNode(fillA, {}, {a});
+    size_t nodeB = graph.addNode(fillB, {}, {b});
+    size_t nodeAdd = graph.addNode(add, {a, b}, {c});
+    size_t nodeRefill = graph.addNode(refillA, {}, {a});
+
+    REQUIRE(graph.getDependencies(nodeA).empty());
+    REQUIRE(graph.getDependencies(nodeB).empty());
+    REQUIRE(graph.getDependencies(nodeAdd) == std::vector<size_t>{nodeA, nodeB});
+    // Write-after-write on a and write-after-read against the add
+    REQUIRE(graph.getDependencies(nodeRefill) == std::vector<size_t>{nodeA, nodeAdd});
+
+    graph.execute();
+    REQUIRE(graph.getChainCount() == 2);
+
+    std::vector<uint32_t> outC = mynydd::fetchData<uint32_t>(contextPtr, c, n);
+    std::vector<uint32_t> outA = mynydd::fetchData<uint32_t>(contextPtr, a, n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(outC[i] == 8);
+        REQUIRE(outA[i] == 11);
+    }
+
+    // The compiled graph is reused; only the parameters change
+    fillA->setPushConstantsData(uint32_t(7));
+    graph.execute();
+    outC = mynydd::fetchData<uint32_t>(contextPtr, c, n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(outC[i] == 12);
+    }
+}
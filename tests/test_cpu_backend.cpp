@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <mynydd/cpu_backend.hpp>
+#include <mynydd/mynydd.hpp>
+
+#include "test_morton_helpers.hpp"
+
+
+namespace {
+
+    struct CpuMortonParams {
+        uint32_t nBits;
+        uint32_t nParticles;
+        glm::dvec3 domainMin;
+        glm::dvec3 domainMax;
+    };
+
+    // C++ port of morton_u32_3d.comp, one invocation per particle
+    void mortonU32Kernel(mynydd::Workgroup& group) {
+        const auto params = group.pushConstants<CpuMortonParams>();
+        const dVec3Aln32* particles = group.binding<dVec3Aln32>(0);
+        uint32_t* keys = group.binding<uint32_t>(1);
+        group.forEachInvocation([&](const mynydd::Invocation& inv) {
+            uint idx = inv.globalInvocationID.x;
+            if (idx >= params.nParticles) {
+                return;
+            }
+            dvec3 norm_pos = (particles[idx].data - params.domainMin) / (params.domainMax - params.domainMin);
+            keys[idx] = morton3D_loop(
+                binPosition(norm_pos.x, params.nBits),
+                binPosition(norm_pos.y, params.nBits),
+                binPosition(norm_pos.z, params.nBits),
+                params.nBits
+            );
+        });
+    }
+
+}
+
+
+TEST_CASE("CPU backend runs the Morton kernel with the same keys as the GPU", "[cpu]") {
+    const uint32_t nBits = 4;
+    std::vector<dVec3Aln32> particles = getMortonTestGridRegularParticleData(nBits);
+    const uint32_t nParticles = static_cast<uint32_t>(particles.size());
+    const double dmax = double((1u << nBits) - 1);
+
+    auto cpu = std::make_shared<mynydd::CpuContext>(4);
+    auto input = std::make_shared<mynydd::CpuBuffer>(nParticles * sizeof(dVec3Aln32));
+    auto output = std::make_shared<mynydd::CpuBuffer>(nParticles * sizeof(uint32_t));
+    mynydd::uploadData<dVec3Aln32>(cpu, particles, input);
+
+    auto step = std::make_shared<mynydd::CpuPipelineStep>(
+        cpu, mortonU32Kernel,
+        std::vector<std::shared_ptr<mynydd::CpuBuffer>>{input, output},
+        glm::uvec3(64, 1, 1), 0
+    );
+    step->dispatchForElements(nParticles);
+    step->setPushConstantsData(CpuMortonParams{nBits, nParticles, glm::dvec3(0.0), glm::dvec3(dmax)});
+    mynydd::executeBatch(cpu, {step});
+    std::vector<uint32_t> cpuKeys = mynydd::fetchData<uint32_t>(cpu, output, nParticles);
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    std::vector<uint32_t> gpuKeys = runMortonTest(contextPtr, nBits, particles);
+    REQUIRE(cpuKeys == gpuKeys);
+}
+
+
+TEST_CASE("CPU backend emulates shared memory and barriers within a workgroup", "[cpu]") {
+    const uint32_t localSize = 128;
+    const uint32_t nGroups = 37;
+    const uint32_t n = localSize * nGroups;
+
+    auto cpu = std::make_shared<mynydd::CpuContext>(3);
+    auto input = std::make_shared<mynydd::CpuBuffer>(n * sizeof(uint32_t));
+    auto output = std::make_shared<mynydd::CpuBuffer>(nGroups * sizeof(uint32_t));
+    std::vector<uint32_t> values(n);
+    std::iota(values.begin(), values.end(), 0u);
+    mynydd::uploadData<uint32_t>(cpu, values, input);
+
+    // Tree reduction in shared memory, the usual GPU pattern with a barrier per level
+    auto reduce = [](mynydd::Workgroup& group) {
+        const uint32_t* in = group.binding<uint32_t>(0);
+        uint32_t* out = group.binding<uint32_t>(1);
+        uint32_t* scratch = group.shared<uint32_t>(group.localSize.x);
+        group.forEachInvocation([&](const mynydd::Invocation& inv) {
+            scratch[inv.localInvocationIndex] = in[inv.globalInvocationID.x];
+        });
+        for (uint32_t stride = group.localSize.x / 2; stride > 0; stride /= 2) {
+            group.forEachInvocation([&](const mynydd::Invocation& inv) {
+                if (inv.localInvocationIndex < stride) {
+                    scratch[inv.localInvocationIndex] += scratch[inv.localInvocationIndex + stride];
+                }
+            });
+        }
+        group.forEachInvocation([&](const mynydd::Invocation& inv) {
+            if (inv.localInvocationIndex == 0) {
+                out[inv.workGroupID.x] = scratch[0];
+            }
+        });
+    };
+
+    auto step = std::make_shared<mynydd::CpuPipelineStep>(
+        cpu, reduce,
+        std::vector<std::shared_ptr<mynydd::CpuBuffer>>{input, output},
+        glm::uvec3(localSize, 1, 1), nGroups
+    );
+    mynydd::executeBatch(cpu, {step});
+    std::vector<uint32_t> sums = mynydd::fetchData<uint32_t>(cpu, output, nGroups);
+
+    for (uint32_t g = 0; g < nGroups; ++g) {
+        uint32_t first = g * localSize;
+        uint32_t expected = localSize * first + localSize * (localSize - 1) / 2;
+        REQUIRE(sums[g] == expected);
+    }
+}
+
+
+TEST_CASE("CPU backend keeps earlier shared arrays valid when allocating more", "[cpu]") {
+    const uint32_t localSize = 64;
+    const uint32_t nGroups = 9;
+    const uint32_t n = localSize * nGroups;
+
+    auto cpu = std::make_shared<mynydd::CpuContext>(3);
+    auto input = std::make_shared<mynydd::CpuBuffer>(n * sizeof(uint32_t));
+    auto output = std::make_shared<mynydd::CpuBuffer>(n * sizeof(uint32_t));
+    std::vector<uint32_t> values(n);
+    std::iota(values.begin(), values.end(), 0u);
+    mynydd::uploadData<uint32_t>(cpu, values, input);
+
+    // Stages the input in one shared array, reverses it into a second, then reads both
+    auto reverse = [](mynydd::Workgroup& group) {
+        const uint32_t* in = group.binding<uint32_t>(0);
+        uint32_t* out = group.binding<uint32_t>(1);
+        uint32_t* staged = group.shared<uint32_t>(group.localSize.x);
+        group.forEachInvocation([&](const mynydd::Invocation& inv) {
+            staged[inv.localInvocationIndex] = in[inv.globalInvocationID.x];
+        });
+        uint64_t* reversed = group.shared<uint64_t>(group.localSize.x);
+        group.forEachInvocation([&](const mynydd::Invocation& inv) {
+            reversed[inv.localInvocationIndex] = staged[group.localSize.x - 1 - inv.localInvocationIndex];
+        });
+        group.forEachInvocation([&](const mynydd::Invocation& inv) {
+            uint32_t i = inv.localInvocationIndex;
+            out[inv.globalInvocationID.x] = staged[i] + static_cast<uint32_t>(reversed[i]);
+        });
+    };
+
+    auto step = std::make_shared<mynydd::CpuPipelineStep>(
+        cpu, reverse,
+        std::vector<std::shared_ptr<mynydd::CpuBuffer>>{input, output},
+        glm::uvec3(localSize, 1, 1), nGroups
+    );
+    step->setSharedMemorySize(localSize * (sizeof(uint32_t) + sizeof(uint64_t)));
+    mynydd::executeBatch(cpu, {step});
+    std::vector<uint32_t> out = mynydd::fetchData<uint32_t>(cpu, output, n);
+
+    // Each pair from the two ends of a group sums to the same value
+    for (uint32_t g = 0; g < nGroups; ++g) {
+        for (uint32_t i = 0; i < localSize; ++i) {
+            REQUIRE(out[g * localSize + i] == 2 * g * localSize + localSize - 1);
+        }
+    }
+
+    // Asking for more than was declared fails rather than reallocating
+    step->setSharedMemorySize(localSize * sizeof(uint32_t));
+    REQUIRE_THROWS_AS(mynydd::executeBatch(cpu, {step}), std::runtime_error);
+}
+
+
+TEST_CASE("CPU backend rethrows kernel errors on the calling thread", "[cpu]") {
+    auto cpu = std::make_shared<mynydd::CpuContext>(2);
+    auto step = std::make_shared<mynydd::CpuPipelineStep>(
+        cpu,
+        [](mynydd::Workgroup& group) {
+            if (group.workGroupID.x == 5) {
+                throw std::runtime_error("workgroup 5 failed");
+            }
+        },
+        std::vector<std::shared_ptr<mynydd::CpuBuffer>>{},
+        glm::uvec3(1, 1, 1), 16
+    );
+    REQUIRE_THROWS_AS(mynydd::executeBatch(cpu, {step}), std::runtime_error);
+    // The pool is still usable afterwards
+    step->groupCountX = 4;
+    REQUIRE_NOTHROW(mynydd::executeBatch(cpu, {step}));
+}
@@ -0,0 +1,148 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/pipelines/layout_transform.hpp>
+
+#include "test_morton_helpers.hpp"
+
+
+TEST_CASE("dVec3Aln32 positions convert to SoA and back", "[layout]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const uint32_t n = 1000; // not a multiple of the tile size
+
+    std::vector<dVec3Aln32> particles(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        particles[i].data = glm::dvec3(i * 0.5, -double(i), i * 1e-3 + 0.25);
+    }
+    auto aos = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(dVec3Aln32), false);
+    auto soa = std::make_shared<mynydd::Buffer>(contextPtr, 3 * n * sizeof(double), false);
+    mynydd::uploadData<dVec3Aln32>(contextPtr, particles, aos);
+
+    mynydd::LayoutTransformPipeline transform(
+        contextPtr, aos, soa, n, mynydd::AosLayout::packed(sizeof(dVec3Aln32), sizeof(double), 3)
+    );
+    transform.toSoa();
+
+    std::vector<double> components = mynydd::fetchData<double>(contextPtr, soa, 3 * n);
+    for (uint32_t i = 0; i < n; ++i) {
+        REQUIRE(components[i] == particles[i].data.x);
+        REQUIRE(components[n + i] == particles[i].data.y);
+        REQUIRE(components[2 * n + i] == particles[i].data.z);
+    }
+
+    // Per-member views of the SoA buffer
+    auto views = mynydd::splitBuffer(soa, sizeof(double), n);
+    REQUIRE(views.size() == 3);
+    REQUIRE(mynydd::fetchData<double>(contextPtr, views[1], n)[7] == particles[7].data.y);
+
+    // Double every member on the host side of SoA and convert back over zeroed records
+    for (double& v : components) {
+        v *= 2.0;
+    }
+    mynydd::uploadData<double>(contextPtr, components, soa);
+    mynydd::uploadData<dVec3Aln32>(contextPtr, std::vector<dVec3Aln32>(n), aos);
+    transform.toAos();
+
+    std::vector<dVec3Aln32> back = mynydd::fetchData<dVec3Aln32>(contextPtr, aos, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        REQUIRE(back[i].data == 2.0 * particles[i].data);
+    }
+}
+
+
+TEST_CASE("Layout transform handles 4 and 16 byte members, strides and pitches", "[layout]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const uint32_t n = 777;
+
+    SECTION("4 byte members at scattered offsets") {
+        // Records of 5 words; convert words 4 and 1, in that order
+        const uint32_t recordWords = 5;
+        std::vector<uint32_t> records(n * recordWords);
+        for (uint32_t i = 0; i < records.size(); ++i) {
+            records[i] = i * 2654435761u;
+        }
+        const uint32_t pitch = n + 3; // padded arrays
+        auto aos = std::make_shared<mynydd::Buffer>(contextPtr, records.size() * sizeof(uint32_t), false);
+        auto soa = std::make_shared<mynydd::Buffer>(contextPtr, 2 * pitch * sizeof(uint32_t), false);
+        mynydd::uploadData<uint32_t>(contextPtr, records, aos);
+
+        mynydd::LayoutTransformPipeline transform(
+            contextPtr, aos, soa, n, mynydd::AosLayout{recordWords * 4, 4, {16, 4}}, pitch * sizeof(uint32_t)
+        );
+        REQUIRE(transform.getSoaPitchBytes() == pitch * sizeof(uint32_t));
+        transform.toSoa();
+
+        std::vector<uint32_t> out = mynydd::fetchData<uint32_t>(contextPtr, soa, 2 * pitch);
+        for (uint32_t i = 0; i < n; ++i) {
+            REQUIRE(out[i] == records[i * recordWords + 4]);
+            REQUIRE(out[pitch + i] == records[i * recordWords + 1]);
+        }
+
+        // Converting back only touches the listed members
+        mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(records.size(), 0u), aos);
+        transform.toAos();
+        std::vector<uint32_t> back = mynydd::fetchData<uint32_t>(contextPtr, aos, records.size());
+        for (uint32_t i = 0; i < n; ++i) {
+            REQUIRE(back[i * recordWords + 0] == 0u);
+            REQUIRE(back[i * recordWords + 1] == records[i * recordWords + 1]);
+            REQUIRE(back[i * recordWords + 4] == records[i * recordWords + 4]);
+        }
+    }
+
+    SECTION("16 byte members") {
+        struct Record {
+            glm::vec4 position;
+            glm::vec4 unused;
+            glm::vec4 velocity;
+        };
+        std::vector<Record> records(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            records[i].position = glm::vec4(float(i), 1.0f, 2.0f, 3.0f);
+            records[i].unused = glm::vec4(-1.0f);
+            records[i].velocity = glm::vec4(0.5f, float(i) * 0.25f, 0.0f, -float(i));
+        }
+        auto aos = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(Record), false);
+        auto soa = std::make_shared<mynydd::Buffer>(contextPtr, 2 * n * sizeof(glm::vec4), false);
+        mynydd::uploadData<Record>(contextPtr, records, aos);
+
+        mynydd::LayoutTransformPipeline transform(
+            contextPtr, aos, soa, n, mynydd::AosLayout{sizeof(Record), sizeof(glm::vec4), {0, 32}}
+        );
+        transform.toSoa();
+
+        std::vector<glm::vec4> out = mynydd::fetchData<glm::vec4>(contextPtr, soa, 2 * n);
+        for (uint32_t i = 0; i < n; ++i) {
+            REQUIRE(out[i] == records[i].position);
+            REQUIRE(out[n + i] == records[i].velocity);
+        }
+    }
+}
+
+
+TEST_CASE("Layout transform rejects unsupported layouts", "[layout]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    auto aos = std::make_shared<mynydd::Buffer>(contextPtr, 64 * 32, false);
+    auto soa = std::make_shared<mynydd::Buffer>(contextPtr, 64 * 24, false);
+
+    // 12 byte members
+    REQUIRE_THROWS_AS(
+        mynydd::LayoutTransformPipeline(contextPtr, aos, soa, 64, mynydd::AosLayout{32, 12, {0}}),
+        std::runtime_error
+    );
+    // Member runs past the end of the record
+    REQUIRE_THROWS_AS(
+        mynydd::LayoutTransformPipeline(contextPtr, aos, soa, 64, mynydd::AosLayout{32, 8, {0, 28}}),
+        std::runtime_error
+    );
+    // SoA buffer too small for four members
+    REQUIRE_THROWS_AS(
+        mynydd::LayoutTransformPipeline(contextPtr, aos, soa, 64, mynydd::AosLayout::packed(32, 8, 4)),
+        std::runtime_error
+    );
+}
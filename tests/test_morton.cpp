@@ -59,6 +59,38 @@ TEST_CASE("Require that Morton decode works as expected", "[morton]") {
 }
 
 
+TEST_CASE("64-bit Morton codes interleave and decode 21 bits per axis", "[morton]") {
+    // Same known values as the 32-bit codes, which they must agree with up to 10 bits
+    uvec2 small = morton3D64(0u, 6u, 7u);
+    REQUIRE(small.x == 436u);
+    REQUIRE(small.y == 0u);
+    REQUIRE(morton3D64(7u, 0u, 6u).x == morton3D(7u, 0u, 6u));
+
+    // The top bit of each axis is the top bit of the code for its axis
+    uvec2 top = morton3D64(1u << 20, 1u << 20, 1u << 20);
+    REQUIRE(top.x == 0u);
+    REQUIRE(top.y == 0x70000000u);
+
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<uint32_t> dist(0, (1u << 21) - 1u);
+    for (int i = 0; i < 10000; ++i) {
+        uint32_t x = dist(rng), y = dist(rng), z = dist(rng);
+        uint64_t expected = 0;
+        for (uint32_t b = 0; b < 21; ++b) {
+            expected |= uint64_t((x >> b) & 1u) << (3 * b);
+            expected |= uint64_t((y >> b) & 1u) << (3 * b + 1);
+            expected |= uint64_t((z >> b) & 1u) << (3 * b + 2);
+        }
+        uvec2 code = morton3D64(x, y, z);
+        REQUIRE(((uint64_t(code.y) << 32) | code.x) == expected);
+
+        uvec3 dec = decodeMorton3D64(code, 21u);
+        REQUIRE(dec.x == x);
+        REQUIRE(dec.y == y);
+        REQUIRE(dec.z == z);
+    }
+}
+
 TEST_CASE("Binning works as expected for Morton curves", "[morton]") {
     // Test some known values again
     uint32_t nbits = 3;
@@ -139,4 +171,49 @@ TEST_CASE("Regression test against vec3/vec4 bit alignment problem; test that la
     REQUIRE(mortonStepOutput[nParticles-1] != 0);
 
 
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("64-bit Morton shader matches the CPU encoding at 21 bits per axis", "[morton]") {
+    const uint32_t nParticles = 1000;
+    const uint32_t nBits = 21;
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    auto inputBuffer = std::make_shared<mynydd::Buffer>(contextPtr, nParticles * sizeof(dVec3Aln32), false);
+    auto outputBuffer = std::make_shared<mynydd::Buffer>(contextPtr, nParticles * 2 * sizeof(uint32_t), false);
+
+    std::vector<dVec3Aln32> inputData(nParticles);
+    std::mt19937 rng(777);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    for (auto& v : inputData) {
+        v.data = glm::dvec3(dist(rng), dist(rng), dist(rng));
+    }
+
+    struct Params {
+        uint32_t nBits;
+        uint32_t nParticles;
+        alignas(32) glm::dvec3 domainMin; // std140 puts a dvec3 on a 32-byte boundary
+        alignas(32) glm::dvec3 domainMax;
+    } mortonParams{nBits, nParticles, glm::dvec3(0.0), glm::dvec3(1.0)};
+
+    auto uniformBuffer = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(Params), true);
+    auto mortonStep = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/morton_u64_3d.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{inputBuffer, outputBuffer, uniformBuffer},
+        (nParticles + 63) / 64
+    );
+
+    mynydd::uploadData<dVec3Aln32>(contextPtr, inputData, inputBuffer);
+    mynydd::uploadUniformData<Params>(contextPtr, mortonParams, uniformBuffer);
+    mynydd::executeBatch(contextPtr, {mortonStep});
+
+    auto keys = mynydd::fetchData<uint32_t>(contextPtr, outputBuffer, nParticles * 2);
+    for (uint32_t i = 0; i < nParticles; ++i) {
+        uvec2 expected = morton3D64(
+            binPosition(inputData[i].data.x, nBits),
+            binPosition(inputData[i].data.y, nBits),
+            binPosition(inputData[i].data.z, nBits)
+        );
+        REQUIRE(keys[2 * i] == expected.x);
+        REQUIRE(keys[2 * i + 1] == expected.y);
+    }
+}
@@ -30,5 +30,7 @@ uint binPosition(double normPos, uint nbits);
 uint ijk2ak(uvec3 ijk, uint nBits);
 // Decode a 3D Morton code into (x,y,z) with up to nbits bits per axis
 uvec3 decodeMorton3D(uint code, uint nbits);
+uvec2 morton3D64(uint x, uint y, uint z);
+uvec3 decodeMorton3D64(uvec2 code, uint nbits);
 
 #endif // TEST_MORTON_HELPERS_HPP
\ No newline at end of file
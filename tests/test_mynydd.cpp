@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <cstdio>
 #include <iostream>
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch_test_macros.hpp>
@@ -8,7 +9,9 @@
 #include <memory>
 #include <vector>
 
+#include <mynydd/embedded_shaders.hpp>
 #include <mynydd/mynydd.hpp>
+#include <mynydd/pipeline_builder.hpp>
 
 TEST_CASE("Compute pipeline processes data for float", "[vulkan]") {
     std::cerr << "Starting compute pipeline test for float..." << std::endl;
@@ -250,3 +253,193 @@ TEST_CASE("Compute pipeline processes data for float 1000 times", "[vulkan]") {
     }
     SUCCEED("Compute shader executed for 1.0/floats.");
 }
+
+TEST_CASE("Dynamic uniform ring gives each recorded dispatch its own parameters", "[vulkan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+
+    size_t n = 1024;
+    uint32_t groupCount = (n + 63) / 64;
+
+    auto data = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+    auto pipeline = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/shader_uniform_dynamic.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{data, mynydd::getUniformRing(contextPtr)->getBuffer()},
+        groupCount
+    );
+    REQUIRE(pipeline->getDynamicOffsets().size() == 1);
+
+    std::vector<float> inputData(n, 0.0f);
+    mynydd::uploadData<float>(contextPtr, inputData, data);
+
+    // Record the same step three times into one command buffer, each with a different value
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    REQUIRE(vkBeginCommandBuffer(contextPtr->commandBuffer, &beginInfo) == VK_SUCCESS);
+
+    mynydd::RuntimeMetricsSnapshot beforePushes = contextPtr->metrics->snapshot();
+    TestParams params{1.0f};
+    pipeline->pushUniformData(params);
+    mynydd::recordCommandBuffer(contextPtr->commandBuffer, pipeline);
+
+    params.val = 2.0f;
+    pipeline->pushUniformData(params);
+    mynydd::recordCommandBuffer(contextPtr->commandBuffer, pipeline);
+
+    params.val = 4.0f;
+    pipeline->pushUniformData(params);
+    // Ring pushes are uploads like any other
+    REQUIRE((contextPtr->metrics->snapshot() - beforePushes).bytesUploaded == 3 * sizeof(TestParams));
+    mynydd::executeBatch(contextPtr, {pipeline}, false);
+
+    std::vector<float> out = mynydd::fetchData<float>(contextPtr, data, n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(out[i] == Catch::Approx(7.0f));
+    }
+}
+
+TEST_CASE("Bindless step reads and writes buffers through device addresses", "[vulkan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    if (!contextPtr->bufferDeviceAddress) {
+        WARN("Device does not support buffer device addresses, skipping");
+        return;
+    }
+
+    uint32_t n = 1000;
+    auto src = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+    auto dst = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+
+    struct BindlessParams {
+        VkDeviceAddress src;
+        VkDeviceAddress dst;
+        uint32_t n;
+        uint32_t pad;
+    };
+
+    auto pipeline = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/bindless.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{},
+        (n + 63) / 64, 1, 1,
+        std::vector<uint32_t>{sizeof(BindlessParams)}
+    );
+
+    std::vector<float> inputData(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        inputData[i] = static_cast<float>(i);
+    }
+    mynydd::uploadData<float>(contextPtr, inputData, src);
+
+    pipeline->setPushConstantsData(BindlessParams{src->getDeviceAddress(), dst->getDeviceAddress(), n, 0});
+    mynydd::executeBatch(contextPtr, {pipeline});
+
+    std::vector<float> out = mynydd::fetchData<float>(contextPtr, dst, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        REQUIRE(out[i] == Catch::Approx(2.0f * i + 1.0f));
+    }
+}
+
+TEST_CASE("Pipeline builder creates steps in one batch and fills the pipeline cache", "[vulkan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+
+    size_t n = 512;
+    auto floats = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+    auto uints = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+
+    mynydd::PipelineBuilder builder(contextPtr);
+    size_t invIdx = builder.add(
+        "shaders/shader.comp.spv", std::vector<std::shared_ptr<mynydd::Buffer>>{floats}, n / 256
+    );
+    size_t fillIdx = builder.add(
+        "shaders/push_constants.comp.spv", std::vector<std::shared_ptr<mynydd::Buffer>>{uints}, n / 256,
+        1, 1, std::vector<uint32_t>{sizeof(uint32_t)}
+    );
+    auto steps = builder.build();
+    REQUIRE(steps.size() == 2);
+
+    std::vector<float> inputData(n);
+    for (size_t i = 0; i < n; ++i) {
+        inputData[i] = static_cast<float>(i);
+    }
+    mynydd::uploadData<float>(contextPtr, inputData, floats);
+    steps[fillIdx]->setPushConstantsData(uint32_t(42));
+    mynydd::executeBatch(contextPtr, {steps[invIdx], steps[fillIdx]});
+
+    std::vector<float> outFloats = mynydd::fetchData<float>(contextPtr, floats, n);
+    std::vector<uint32_t> outUints = mynydd::fetchData<uint32_t>(contextPtr, uints, n);
+    for (size_t i = 1; i < n; ++i) {
+        REQUIRE(outFloats[i] == Catch::Approx(1.0 / static_cast<float>(i)));
+        REQUIRE(outUints[i] == 42);
+    }
+
+    // Cache round trip into a fresh context
+    const std::string cachePath = "test_pipeline_cache.bin";
+    mynydd::savePipelineCache(contextPtr, cachePath);
+    auto otherContextPtr = std::make_shared<mynydd::VulkanContext>();
+    REQUIRE(mynydd::loadPipelineCache(otherContextPtr, cachePath));
+    REQUIRE_FALSE(mynydd::loadPipelineCache(otherContextPtr, "does_not_exist.bin"));
+    std::remove(cachePath.c_str());
+}
+
+TEST_CASE("Library shaders are embedded in the library", "[vulkan]") {
+    for (const char* name : {"histogram.comp", "radix_sort.comp", "morton_u32_3d.comp"}) {
+        auto embedded = mynydd::getEmbeddedShader(name);
+        REQUIRE(embedded == mynydd::readShaderFile((std::string("shaders/") + name + ".spv").c_str()));
+    }
+    // Test shaders are not part of the library
+    REQUIRE_THROWS_AS(mynydd::getEmbeddedShader("push_constants.comp"), std::runtime_error);
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    size_t n = 1024;
+    auto indices = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto step = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, mynydd::getEmbeddedShader("init_range_index.comp"), "init_range_index.comp",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{indices}, 1, 1, 1,
+        std::vector<uint32_t>{sizeof(uint32_t)}
+    );
+    step->dispatchForElements(n);
+    step->setPushConstantsData(static_cast<uint32_t>(n));
+    mynydd::executeBatch(contextPtr, {step});
+
+    auto out = mynydd::fetchData<uint32_t>(contextPtr, indices, n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(out[i] == i);
+    }
+}
+
+TEST_CASE("Runtime metrics count submissions, barriers and host transfers", "[vulkan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    size_t n = 1024;
+
+    auto b1 = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+    auto b2 = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+    auto b3 = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(float), false);
+    auto pipeline1 = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/multistep_1.comp.spv", std::vector<std::shared_ptr<mynydd::Buffer>>{b1, b2}, 256
+    );
+    auto pipeline2 = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/multistep_2.comp.spv", std::vector<std::shared_ptr<mynydd::Buffer>>{b2, b3}, 256
+    );
+    auto pipeline3 = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/multistep_3.comp.spv", std::vector<std::shared_ptr<mynydd::Buffer>>{b2, b3, b1}, 256
+    );
+
+    mynydd::RuntimeMetricsSnapshot created = contextPtr->metrics->snapshot();
+    REQUIRE(created.descriptorPoolsCreated == 3);
+    REQUIRE(created.descriptorSetsAllocated == 3);
+
+    mynydd::uploadData<float>(contextPtr, std::vector<float>(n, 1.0f), b1);
+    mynydd::executeBatch(contextPtr, {pipeline1, pipeline2, pipeline3});
+    mynydd::fetchData<float>(contextPtr, b3, n);
+
+    mynydd::RuntimeMetricsSnapshot delta = contextPtr->metrics->snapshot() - created;
+    REQUIRE(delta.submits == 1);
+    REQUIRE(delta.fenceWaits == 1);
+    REQUIRE(delta.barriers == 2); // none after the last step
+    REQUIRE(delta.descriptorPoolsCreated == 0);
+    REQUIRE(delta.bytesUploaded == n * sizeof(float));
+    REQUIRE(delta.bytesDownloaded == n * sizeof(float));
+    REQUIRE(delta.mapCalls == 2);
+    REQUIRE(delta.unmapCalls == 2);
+
+    contextPtr->metrics->reset();
+    REQUIRE(contextPtr->metrics->snapshot().submits == 0);
+}
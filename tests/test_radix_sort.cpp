@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <sys/types.h>
 #define CATCH_CONFIG_MAIN
@@ -6,8 +7,10 @@
 
 #include <iostream>
 #include <chrono>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <memory>
+#include <numeric>
 #include <random>
 #include <vector>
 
@@ -106,7 +109,8 @@ TEST_CASE("Radix histogram compute shader correctly generates bin counts", "[sor
         .bitOffset = 0,
         .numBins = numBins,
         .totalSize = static_cast<uint32_t>(n),
-        .itemsPerGroup = itemsPerGroup
+        .itemsPerGroup = itemsPerGroup,
+        .keyWords = 1
     };
 
     mynydd::uploadUniformData<mynydd::RadixParams>(contextPtr, params, uniform);
@@ -278,10 +282,11 @@ std::vector<uint32_t> runFullRadixSortTest(
         for (uint32_t bin = 0; bin < expected_wg_histogram.size(); ++bin) {
             REQUIRE(out_wg_hist[bin] == expected_wg_histogram[bin]);
         }
-        auto out_wg_hist_transposed = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.transposedHistograms, radixSortPipeline.groupCount * radixSortPipeline.numBins);
+        // The workgroup prefix sums are bin-major; transpose the histograms to match
+        std::vector<uint32_t> out_wg_hist_transposed(out_wg_hist.size());
         for (uint32_t wg = 0; wg < radixSortPipeline.groupCount; ++wg) {
             for (uint32_t bin = 0; bin < radixSortPipeline.numBins; ++bin) {
-                REQUIRE(out_wg_hist[wg * radixSortPipeline.numBins + bin] == out_wg_hist_transposed[bin * radixSortPipeline.groupCount + wg]);
+                out_wg_hist_transposed[bin * radixSortPipeline.groupCount + wg] = out_wg_hist[wg * radixSortPipeline.numBins + bin];
             }
         }
         // for (uint32_t bin = 0; bin < numBins; ++bin) {
@@ -476,6 +481,310 @@ TEST_CASE("Full 32-bit radix sort pipeline with 8-bit passes for n > 2^16 (regre
     auto output_retrieved = runFullRadixSortTest(contextPtr, inputData);
 }
 
+TEST_CASE("Radix sort keeps equal keys in input order", "[sort]") {
+    // Few distinct keys and a partial last workgroup: every bin holds long runs, so
+    // any error in the local ranking shows up as out-of-order indices
+    const size_t n = 3 * 256 + 100;
+    std::vector<uint32_t> inputData(n);
+    std::mt19937 rng(777);
+    std::uniform_int_distribution<uint32_t> dist(0, 5);
+    for (auto& v : inputData) v = dist(rng) << 20;
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    mynydd::RadixSortPipeline radixSortPipeline(contextPtr, 256, static_cast<uint32_t>(n));
+    mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+    radixSortPipeline.execute();
+
+    auto keys = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), n);
+    auto indices = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedIndicesBuffer(), n);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(keys[i] == inputData[indices[i]]);
+        if (i > 0) {
+            REQUIRE(keys[i - 1] <= keys[i]);
+            if (keys[i - 1] == keys[i]) {
+                REQUIRE(indices[i - 1] < indices[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Radix sort records all passes into one submission", "[sort]") {
+    const size_t n = 5 * 256 + 17;
+    std::vector<uint32_t> inputData(n);
+    std::mt19937 rng(4242);
+    std::uniform_int_distribution<uint32_t> dist;
+    for (auto& v : inputData) v = dist(rng);
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    mynydd::RadixSortPipeline radixSortPipeline(contextPtr, 256, static_cast<uint32_t>(n));
+    std::vector<uint32_t> expected = inputData;
+    std::sort(expected.begin(), expected.end());
+
+    SECTION("execute") {
+        mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+        mynydd::RuntimeMetricsSnapshot before = contextPtr->metrics->snapshot();
+        radixSortPipeline.execute();
+        mynydd::RuntimeMetricsSnapshot delta = contextPtr->metrics->snapshot() - before;
+        REQUIRE(delta.submits == 1);
+        REQUIRE(delta.fenceWaits == 1);
+    }
+
+    SECTION("recorded into the caller's command buffer") {
+        mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        REQUIRE(vkBeginCommandBuffer(contextPtr->commandBuffer, &beginInfo) == VK_SUCCESS);
+        mynydd::RuntimeMetricsSnapshot before = contextPtr->metrics->snapshot();
+        radixSortPipeline.record(contextPtr->commandBuffer);
+        REQUIRE((contextPtr->metrics->snapshot() - before).submits == 0);
+        mynydd::submitAndWait(contextPtr);
+        REQUIRE((contextPtr->metrics->snapshot() - before).submits == 1);
+    }
+
+    auto keys = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), n);
+    auto indices = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedIndicesBuffer(), n);
+    REQUIRE(keys == expected);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE(keys[i] == inputData[indices[i]]);
+    }
+}
+
+TEST_CASE("Radix sort runs only the passes its key bits need", "[sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const size_t n = 3 * 256 + 40;
+
+    // 12 bits: two passes, output back in buffer A; 20 bits: three passes, output in B
+    for (uint32_t keyBits : {12u, 20u}) {
+        std::vector<uint32_t> inputData(n);
+        std::mt19937 rng(keyBits);
+        std::uniform_int_distribution<uint32_t> dist(0, (1u << keyBits) - 1u);
+        for (auto& v : inputData) v = dist(rng);
+
+        mynydd::RadixSortPipeline radixSortPipeline(contextPtr, 256, static_cast<uint32_t>(n), keyBits);
+        REQUIRE(radixSortPipeline.nPasses == (keyBits + 7) / 8);
+        mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+        radixSortPipeline.execute();
+
+        auto keys = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), n);
+        auto indices = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedIndicesBuffer(), n);
+        std::vector<uint32_t> expected = inputData;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(keys == expected);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(keys[i] == inputData[indices[i]]);
+        }
+    }
+
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 256, 256, 33), std::runtime_error);
+}
+
+TEST_CASE("Onesweep radix sort matches std::sort", "[sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+
+    // Many tiles, so most look-backs cross several predecessors; an odd pass count
+    // leaves the result in the B buffers
+    for (uint32_t keyBits : {32u, 20u}) {
+        const size_t n = (1 << 17) + 77;
+        std::vector<uint32_t> inputData(n);
+        std::mt19937 rng(keyBits * 31);
+        std::uniform_int_distribution<uint32_t> dist(0, keyBits == 32 ? UINT32_MAX : (1u << keyBits) - 1u);
+        for (auto& v : inputData) v = dist(rng);
+
+        mynydd::RadixSortPipeline radixSortPipeline(
+            contextPtr, 256, static_cast<uint32_t>(n),
+            mynydd::RadixSortOptions{keyBits, mynydd::RadixSortBackend::Onesweep}
+        );
+        mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+        radixSortPipeline.execute();
+
+        auto keys = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), n);
+        auto indices = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedIndicesBuffer(), n);
+        std::vector<uint32_t> expected = inputData;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(keys == expected);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(keys[i] == inputData[indices[i]]);
+            if (i > 0 && keys[i - 1] == keys[i]) {
+                REQUIRE(indices[i - 1] < indices[i]);
+            }
+        }
+
+        // Sorting again reuses the tile counters and status words
+        mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+        radixSortPipeline.execute();
+        REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), n) == expected);
+    }
+
+    REQUIRE_THROWS_AS(
+        mynydd::RadixSortPipeline(
+            contextPtr, 128, 1024, mynydd::RadixSortOptions{32, mynydd::RadixSortBackend::Onesweep}
+        ),
+        std::runtime_error
+    );
+}
+
+TEST_CASE("Radix sort moves value payloads or nothing with the keys", "[sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const size_t n = 6 * 256 + 31;
+    std::vector<uint32_t> inputData(n);
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<uint32_t> dist(0, (1u << 16) - 1u);
+    for (auto& v : inputData) v = dist(rng);
+
+    // Stable order of the keys, as the payload should end up
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return inputData[a] < inputData[b]; });
+
+    for (auto backend : {mynydd::RadixSortBackend::MultiPass, mynydd::RadixSortBackend::Onesweep}) {
+        for (uint32_t payloadBytes : {4u, 8u, 16u, 32u}) {
+            const uint32_t words = payloadBytes / 4;
+            mynydd::RadixSortPipeline radixSortPipeline(
+                contextPtr, 256, static_cast<uint32_t>(n),
+                mynydd::RadixSortOptions{16, backend, mynydd::RadixSortPayload::Values, payloadBytes}
+            );
+            std::vector<uint32_t> payload(n * words);
+            for (size_t i = 0; i < payload.size(); ++i) {
+                payload[i] = uint32_t(i) * 7919u + 1u;
+            }
+            mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+            mynydd::uploadData<uint32_t>(contextPtr, payload, radixSortPipeline.getPayloadInputBuffer());
+            radixSortPipeline.execute();
+
+            auto sorted = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedPayloadBuffer(), n * words);
+            for (size_t i = 0; i < n; ++i) {
+                for (uint32_t w = 0; w < words; ++w) {
+                    REQUIRE(sorted[i * words + w] == payload[order[i] * words + w]);
+                }
+            }
+        }
+
+        mynydd::RadixSortPipeline keysOnly(
+            contextPtr, 256, static_cast<uint32_t>(n),
+            mynydd::RadixSortOptions{16, backend, mynydd::RadixSortPayload::KeysOnly}
+        );
+        REQUIRE(keysOnly.getSortedIndicesBuffer() == nullptr);
+        mynydd::uploadData<uint32_t>(contextPtr, inputData, keysOnly.m_ioBufferA);
+        keysOnly.execute();
+        std::vector<uint32_t> expected = inputData;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, keysOnly.getSortedMortonKeysBuffer(), n) == expected);
+    }
+
+    REQUIRE_THROWS_AS(
+        mynydd::RadixSortPipeline(
+            contextPtr, 256, 1024,
+            mynydd::RadixSortOptions{32, mynydd::RadixSortBackend::MultiPass, mynydd::RadixSortPayload::Values, 12}
+        ),
+        std::runtime_error
+    );
+}
+
+TEST_CASE("Radix sort orders 8-byte keys on both words", "[sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const size_t n = 5 * 256 + 77;
+    for (uint32_t keyBits : {64u, 45u}) {
+        std::mt19937_64 rng(keyBits);
+        std::vector<uint64_t> keys(n);
+        for (auto& k : keys) {
+            k = keyBits == 64 ? rng() : rng() & ((uint64_t(1) << keyBits) - 1u);
+        }
+        // Few distinct high words, so ties in the high word are ordered by the low one
+        for (size_t i = 0; i < n; i += 3) {
+            keys[i] &= 0xffffffffu;
+        }
+
+        for (auto backend : {mynydd::RadixSortBackend::MultiPass, mynydd::RadixSortBackend::Onesweep}) {
+            mynydd::RadixSortOptions options{keyBits, backend};
+            options.keyBytes = 8;
+            mynydd::RadixSortPipeline radixSortPipeline(contextPtr, 256, static_cast<uint32_t>(n), options);
+            REQUIRE(radixSortPipeline.nPasses == (keyBits + 7) / 8);
+
+            std::vector<uint32_t> words(2 * n);
+            std::memcpy(words.data(), keys.data(), n * sizeof(uint64_t));
+            mynydd::uploadData<uint32_t>(contextPtr, words, radixSortPipeline.m_ioBufferA);
+            radixSortPipeline.execute();
+
+            auto sortedWords = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), 2 * n);
+            auto indices = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedIndicesBuffer(), n);
+            std::vector<uint64_t> sorted(n);
+            std::memcpy(sorted.data(), sortedWords.data(), n * sizeof(uint64_t));
+
+            std::vector<uint64_t> expected = keys;
+            std::sort(expected.begin(), expected.end());
+            REQUIRE(sorted == expected);
+            for (size_t i = 0; i < n; ++i) {
+                REQUIRE(keys[indices[i]] == sorted[i]);
+            }
+        }
+    }
+
+    mynydd::RadixSortOptions tooWide{40};
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 256, 1024, tooWide), std::runtime_error);
+    tooWide.keyBytes = 2;
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 256, 1024, tooWide), std::runtime_error);
+}
+
+TEST_CASE("Radix sort takes any digit width and several keys per thread", "[sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const size_t n = 20000 + 13;
+    std::mt19937 rng(50);
+    std::vector<uint32_t> inputData(n);
+    for (auto& v : inputData) v = rng();
+
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return inputData[a] < inputData[b]; });
+
+    for (uint32_t bitsPerPass : {4u, 6u, 8u, 11u}) {
+        for (uint32_t itemsPerGroup : {256u, 2048u, 4096u}) {
+            mynydd::RadixSortOptions options;
+            options.bitsPerPass = bitsPerPass;
+            mynydd::RadixSortPipeline radixSortPipeline(contextPtr, itemsPerGroup, static_cast<uint32_t>(n), options);
+            REQUIRE(radixSortPipeline.nPasses == (32 + bitsPerPass - 1) / bitsPerPass);
+            REQUIRE(radixSortPipeline.numBins == (1u << bitsPerPass));
+            REQUIRE(radixSortPipeline.groupCount == (n + itemsPerGroup - 1) / itemsPerGroup);
+
+            mynydd::uploadData<uint32_t>(contextPtr, inputData, radixSortPipeline.m_ioBufferA);
+            radixSortPipeline.execute();
+
+            auto keys = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedMortonKeysBuffer(), n);
+            auto indices = mynydd::fetchData<uint32_t>(contextPtr, radixSortPipeline.getSortedIndicesBuffer(), n);
+            for (size_t i = 0; i < n; ++i) {
+                REQUIRE(indices[i] == order[i]);
+                REQUIRE(keys[i] == inputData[order[i]]);
+            }
+        }
+    }
+
+    // 11-bit digits straddle the two words of 8-byte keys
+    std::mt19937_64 rng64(51);
+    std::vector<uint64_t> wide(n);
+    for (auto& k : wide) k = rng64();
+    mynydd::RadixSortOptions wideOptions{64};
+    wideOptions.keyBytes = 8;
+    wideOptions.bitsPerPass = 11;
+    mynydd::RadixSortPipeline wideSort(contextPtr, 1024, static_cast<uint32_t>(n), wideOptions);
+    std::vector<uint32_t> words(2 * n);
+    std::memcpy(words.data(), wide.data(), n * sizeof(uint64_t));
+    mynydd::uploadData<uint32_t>(contextPtr, words, wideSort.m_ioBufferA);
+    wideSort.execute();
+    auto sortedWords = mynydd::fetchData<uint32_t>(contextPtr, wideSort.getSortedMortonKeysBuffer(), 2 * n);
+    std::vector<uint64_t> sorted(n);
+    std::memcpy(sorted.data(), sortedWords.data(), n * sizeof(uint64_t));
+    std::sort(wide.begin(), wide.end());
+    REQUIRE(sorted == wide);
+
+    mynydd::RadixSortOptions bad;
+    bad.bitsPerPass = 7;
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 256, 1024, bad), std::runtime_error);
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 384, 1024), std::runtime_error);
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 8192, 1024), std::runtime_error);
+    bad.bitsPerPass = 11;
+    bad.backend = mynydd::RadixSortBackend::Onesweep;
+    REQUIRE_THROWS_AS(mynydd::RadixSortPipeline(contextPtr, 256, 1024, bad), std::runtime_error);
+}
+
 void run_full_pipeline_morton(uint32_t nBits) {
     auto contextPtr = std::make_shared<mynydd::VulkanContext>();
     auto particles = getMortonTestGridRegularParticleData(nBits);
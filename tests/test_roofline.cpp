@@ -0,0 +1,109 @@
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/roofline.hpp>
+#include <mynydd/tracer.hpp>
+
+TEST_CASE("Workload model is estimated from bindings and dispatch size", "[roofline]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    uint32_t n = 512;
+    auto a = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto b = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto c = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto add = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/graph_add.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{a, b, c},
+        n / 256
+    );
+
+    // a and b are readonly, c is writeonly
+    mynydd::WorkloadModel estimate = add->getWorkloadModel();
+    REQUIRE(estimate.bytesRead == 2 * n * sizeof(uint32_t));
+    REQUIRE(estimate.bytesWritten == n * sizeof(uint32_t));
+    REQUIRE(estimate.ops == n);
+
+    add->setWorkloadModel({8, 4, 1});
+    REQUIRE(add->getWorkloadModel().bytesMoved() == 12);
+    REQUIRE(add->estimateWorkloadModel().ops == n);
+}
+
+TEST_CASE("Roofline report combines GPU times with measured device peaks", "[roofline]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    mynydd::DevicePeaks peaks = mynydd::measureDevicePeaks(contextPtr, 16ull << 20);
+    REQUIRE(peaks.bandwidthGBs > 0.0);
+    REQUIRE(peaks.gflops > 0.0);
+    REQUIRE(contextPtr->tracer == nullptr); // the probes' tracer is not left behind
+
+    auto tracer = mynydd::enableTracing(contextPtr);
+    if (!tracer->gpuTimingSupported()) {
+        WARN("Queue has no timestamp support; skipping roofline report");
+        return;
+    }
+
+    uint32_t n = 1 << 20;
+    auto a = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto b = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto c = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto add = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/graph_add.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{a, b, c},
+        n / 256
+    );
+    for (int i = 0; i < 3; ++i) {
+        mynydd::executeBatch(contextPtr, {add});
+    }
+
+    auto entries = mynydd::buildRooflineReport(*tracer, {add}, peaks);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].dispatches == 3);
+    REQUIRE(entries[0].meanSeconds > 0.0);
+    REQUIRE(entries[0].achievedGBs > 0.0);
+    REQUIRE(entries[0].memoryBound); // one add per 12 bytes is far below any ridge point
+
+    std::ostringstream report;
+    mynydd::printRooflineReport(report, entries, peaks);
+    REQUIRE(report.str().find("graph_add") != std::string::npos);
+}
+
+
+TEST_CASE("Unavailable device peaks give no fractions instead of infinities", "[roofline]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    auto tracer = mynydd::enableTracing(contextPtr);
+    if (!tracer->gpuTimingSupported()) {
+        WARN("Queue has no timestamp support; skipping roofline report");
+        return;
+    }
+
+    uint32_t n = 1 << 16;
+    auto a = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto b = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto c = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto add = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/graph_add.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{a, b, c},
+        n / 256
+    );
+    mynydd::executeBatch(contextPtr, {add});
+
+    // As measureDevicePeaks reports a compute probe that only ever timed at zero
+    mynydd::DevicePeaks peaks;
+    peaks.bandwidthGBs = 10.0;
+    REQUIRE(peaks.ridgeIntensity() == 0.0);
+
+    auto entries = mynydd::buildRooflineReport(*tracer, {add}, peaks);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(std::isfinite(entries[0].bandwidthFraction));
+    REQUIRE(entries[0].computeFraction == 0.0);
+
+    std::ostringstream report;
+    mynydd::printRooflineReport(report, entries, peaks);
+    REQUIRE(report.str().find("compute unavailable") != std::string::npos);
+    REQUIRE(report.str().find("inf") == std::string::npos);
+    REQUIRE(report.str().find("nan") == std::string::npos);
+}
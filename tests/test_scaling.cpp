@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <mynydd/mynydd.hpp>
+
+TEST_CASE("Group counts above the X limit are folded into 2D", "[scale]") {
+    REQUIRE(mynydd::foldGroupCount(1000, 65535, 65535) == std::array<uint32_t, 3>{1000, 1, 1});
+    REQUIRE(mynydd::foldGroupCount(65535, 65535, 65535) == std::array<uint32_t, 3>{65535, 1, 1});
+
+    // 50M elements at 256 per workgroup
+    uint64_t groups = (50'000'000ull + 255) / 256;
+    auto folded = mynydd::foldGroupCount(groups, 65535, 65535);
+    REQUIRE(folded[0] <= 65535);
+    REQUIRE(folded[2] == 1);
+    uint64_t total = uint64_t(folded[0]) * folded[1];
+    REQUIRE(total >= groups);
+    REQUIRE(total - groups < folded[1]); // at most one partial row
+
+    REQUIRE_THROWS_AS(mynydd::foldGroupCount(uint64_t(65535) * 65535 + 1, 65535, 65535), std::runtime_error);
+}
+
+TEST_CASE("Kernels index a folded dispatch linearly and skip the idle tail", "[scale]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const uint32_t n = 5000; // 20 workgroups of 256
+    auto indices = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(n, 0xFFFFFFFFu), indices);
+
+    auto step = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/init_range_index.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{indices},
+        1, 1, 1,
+        std::vector<uint32_t>{sizeof(uint32_t)}
+    );
+    // Pretend the device allows only 7 workgroups in X: 3 rows of 7, one idle
+    auto folded = mynydd::foldGroupCount((n + 255) / 256, 7, 65535);
+    REQUIRE(folded == std::array<uint32_t, 3>{7, 3, 1});
+    step->setGroupCount(folded);
+    step->setPushConstantsData(n);
+    mynydd::executeBatch(contextPtr, {step});
+
+    std::vector<uint32_t> expected(n);
+    std::iota(expected.begin(), expected.end(), 0u);
+    REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, indices, n) == expected);
+}
+
+TEST_CASE("Buffer views bind chunks of one allocation", "[scale]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const uint32_t n = 4096;
+    const uint32_t chunk = 1024; // 4 KiB, a multiple of any minStorageBufferOffsetAlignment
+    auto whole = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(n, 0u), whole);
+
+    auto chunks = mynydd::splitBuffer(whole, sizeof(uint32_t), chunk);
+    REQUIRE(chunks.size() == n / chunk);
+    REQUIRE(chunks[2]->isView());
+    REQUIRE(chunks[2]->getOffset() == 2 * chunk * sizeof(uint32_t));
+    REQUIRE(chunks[2]->overlaps(*whole));
+    REQUIRE_FALSE(chunks[2]->overlaps(*chunks[1]));
+    REQUIRE(mynydd::maxElementsPerBinding(contextPtr, {sizeof(uint32_t), 32}) > 0);
+
+    // Each chunk is filled with chunk-relative indices by its own dispatch
+    std::vector<std::shared_ptr<mynydd::PipelineStep>> steps;
+    for (const auto& view : chunks) {
+        auto step = std::make_shared<mynydd::PipelineStep>(
+            contextPtr, "shaders/init_range_index.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{view},
+            1, 1, 1,
+            std::vector<uint32_t>{sizeof(uint32_t)}
+        );
+        step->dispatchForElements(chunk);
+        step->setPushConstantsData(chunk);
+        steps.push_back(step);
+    }
+    mynydd::executeBatch(contextPtr, steps);
+
+    std::vector<uint32_t> result = mynydd::fetchData<uint32_t>(contextPtr, whole, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        REQUIRE(result[i] == i % chunk);
+    }
+
+    // Views read and write through their offset on the host too
+    mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(chunk, 7u), chunks[3]);
+    REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, whole, n)[3 * chunk] == 7u);
+    REQUIRE(mynydd::fetchData<uint32_t>(contextPtr, chunks[3], 1)[0] == 7u);
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/pipelines/scan.hpp>
+
+
+namespace {
+
+    template<typename T, typename Op>
+    std::vector<T> hostScan(const std::vector<T>& values, Op op, T identity, bool inclusive) {
+        std::vector<T> out(values.size());
+        T running = identity;
+        for (size_t i = 0; i < values.size(); ++i) {
+            T next = op(running, values[i]);
+            out[i] = inclusive ? next : running;
+            running = next;
+        }
+        return out;
+    }
+
+    template<typename T>
+    std::vector<T> runScan(
+        std::shared_ptr<mynydd::VulkanContext> contextPtr,
+        const std::vector<T>& values,
+        const mynydd::ScanOptions& options
+    ) {
+        auto input = std::make_shared<mynydd::Buffer>(contextPtr, values.size() * sizeof(T), false);
+        auto output = std::make_shared<mynydd::Buffer>(contextPtr, values.size() * sizeof(T), false);
+        mynydd::uploadData<T>(contextPtr, values, input);
+        mynydd::ScanPipeline scan(contextPtr, input, output, static_cast<uint32_t>(values.size()), options);
+        scan.execute();
+        return mynydd::fetchData<T>(contextPtr, output, values.size());
+    }
+
+}
+
+
+TEST_CASE("Scan pipeline sums uint32 arrays of any length", "[scan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<uint32_t> dist(0, 100);
+
+    // One partial tile, exactly one tile, two levels, and three levels
+    for (uint32_t n : {1u, 1000u, 1024u, 1025u, 300000u, (1u << 21) + 7u}) {
+        std::vector<uint32_t> values(n);
+        for (auto& v : values) v = dist(rng);
+        auto plus = [](uint32_t a, uint32_t b) { return a + b; };
+
+        REQUIRE(runScan<uint32_t>(contextPtr, values, {}) == hostScan<uint32_t>(values, plus, 0u, false));
+        REQUIRE(
+            runScan<uint32_t>(contextPtr, values, {mynydd::ScanElementType::Uint32, mynydd::ScanOp::Add, true}) ==
+            hostScan<uint32_t>(values, plus, 0u, true)
+        );
+    }
+}
+
+
+TEST_CASE("Scan pipeline handles uint64 and float elements and the max operator", "[scan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const uint32_t n = 200000;
+    std::mt19937 rng(11);
+
+    SECTION("uint64 sums carry into the high word") {
+        std::vector<uint64_t> values(n);
+        std::uniform_int_distribution<uint64_t> dist(0, uint64_t(1) << 40);
+        for (auto& v : values) v = dist(rng);
+        auto out = runScan<uint64_t>(contextPtr, values, {mynydd::ScanElementType::Uint64, mynydd::ScanOp::Add, true});
+        REQUIRE(out == hostScan<uint64_t>(values, [](uint64_t a, uint64_t b) { return a + b; }, 0, true));
+        REQUIRE(out.back() > UINT32_MAX);
+    }
+
+    SECTION("uint64 max compares both words") {
+        std::vector<uint64_t> values(n);
+        std::uniform_int_distribution<uint64_t> dist;
+        for (auto& v : values) v = dist(rng);
+        auto out = runScan<uint64_t>(contextPtr, values, {mynydd::ScanElementType::Uint64, mynydd::ScanOp::Max, false});
+        REQUIRE(out == hostScan<uint64_t>(values, [](uint64_t a, uint64_t b) { return std::max(a, b); }, 0, false));
+    }
+
+    SECTION("uint32 max") {
+        std::vector<uint32_t> values(n);
+        std::uniform_int_distribution<uint32_t> dist;
+        for (auto& v : values) v = dist(rng);
+        auto out = runScan<uint32_t>(contextPtr, values, {mynydd::ScanElementType::Uint32, mynydd::ScanOp::Max, true});
+        REQUIRE(out == hostScan<uint32_t>(values, [](uint32_t a, uint32_t b) { return std::max(a, b); }, 0u, true));
+    }
+
+    SECTION("float sums") {
+        std::vector<float> values(n);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for (auto& v : values) v = dist(rng);
+        auto out = runScan<float>(contextPtr, values, {mynydd::ScanElementType::Float32, mynydd::ScanOp::Add, false});
+        std::vector<double> values64(values.begin(), values.end());
+        auto expected = hostScan<double>(values64, [](double a, double b) { return a + b; }, 0.0, false);
+        for (uint32_t i = 0; i < n; i += 997) {
+            REQUIRE(out[i] == Catch::Approx(expected[i]).epsilon(1e-4));
+        }
+    }
+
+    SECTION("exclusive float max starts from -inf") {
+        std::vector<float> values(n);
+        std::uniform_real_distribution<float> dist(-1e6f, -1.0f);
+        for (auto& v : values) v = dist(rng);
+        auto out = runScan<float>(contextPtr, values, {mynydd::ScanElementType::Float32, mynydd::ScanOp::Max, false});
+        const float ninf = -std::numeric_limits<float>::infinity();
+        REQUIRE(out == hostScan<float>(values, [](float a, float b) { return std::max(a, b); }, ninf, false));
+    }
+}
+
+
+TEST_CASE("Scan pipeline scans in place", "[scan]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    const uint32_t n = 5000;
+    std::vector<uint32_t> values(n, 1u);
+    auto buffer = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    mynydd::uploadData<uint32_t>(contextPtr, values, buffer);
+
+    mynydd::ScanPipeline scan(contextPtr, buffer, buffer, n);
+    scan.execute();
+    auto out = mynydd::fetchData<uint32_t>(contextPtr, buffer, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        REQUIRE(out[i] == i);
+    }
+
+    REQUIRE_THROWS_AS(mynydd::ScanPipeline(contextPtr, buffer, buffer, n + 1), std::runtime_error);
+}
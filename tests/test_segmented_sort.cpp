@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/pipelines/segmented_sort.hpp>
+
+
+namespace {
+
+    // Sorts each segment on the GPU and checks it against a stable sort on the host
+    void checkSegmentedSort(
+        std::shared_ptr<mynydd::VulkanContext> contextPtr,
+        const std::vector<uint32_t>& keys,
+        const std::vector<uint32_t>& offsets,
+        uint32_t expectedLong
+    ) {
+        auto keysBuffer = std::make_shared<mynydd::Buffer>(contextPtr, keys.size() * sizeof(uint32_t), false);
+        mynydd::uploadData<uint32_t>(contextPtr, keys, keysBuffer);
+
+        mynydd::SegmentedSortPipeline sort(contextPtr, keysBuffer, offsets);
+        REQUIRE(sort.getLongSegmentCount() == expectedLong);
+        // Both paths go out in one submission
+        auto before = contextPtr->metrics->snapshot();
+        sort.execute();
+        REQUIRE((contextPtr->metrics->snapshot() - before).submits == 1);
+
+        auto sortedKeys = mynydd::fetchData<uint32_t>(contextPtr, sort.getSortedKeysBuffer(), keys.size());
+        auto sortedIndices = mynydd::fetchData<uint32_t>(contextPtr, sort.getSortedIndicesBuffer(), keys.size());
+
+        std::vector<uint32_t> expected(keys.size());
+        std::iota(expected.begin(), expected.end(), 0u);
+        for (size_t s = 0; s + 1 < offsets.size(); ++s) {
+            std::stable_sort(
+                expected.begin() + offsets[s], expected.begin() + offsets[s + 1],
+                [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; }
+            );
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            REQUIRE(sortedIndices[i] == expected[i]);
+            REQUIRE(sortedKeys[i] == keys[expected[i]]);
+        }
+    }
+
+}
+
+
+TEST_CASE("Segmented sort orders thousands of small segments in one submission", "[segmented_sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint32_t> lengths(0, 300);
+    std::uniform_int_distribution<uint32_t> values(0, 50); // plenty of ties
+
+    std::vector<uint32_t> offsets{0};
+    for (int s = 0; s < 3000; ++s) {
+        offsets.push_back(offsets.back() + lengths(rng));
+    }
+    // Exactly the shared memory capacity, a single key, and an empty segment
+    offsets.push_back(offsets.back() + mynydd::SegmentedSortPipeline::localSortCapacity);
+    offsets.push_back(offsets.back() + 1);
+    offsets.push_back(offsets.back());
+
+    std::vector<uint32_t> keys(offsets.back());
+    for (auto& k : keys) k = values(rng);
+
+    checkSegmentedSort(contextPtr, keys, offsets, 0);
+}
+
+TEST_CASE("Segmented sort radix sorts segments too long for one workgroup", "[segmented_sort]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    std::mt19937 rng(12);
+    std::uniform_int_distribution<uint32_t> values;
+
+    // Short and long segments interleaved, so both paths write into the same outputs
+    std::vector<uint32_t> offsets{0};
+    for (uint32_t len : {5u, 5000u, 1024u, 1025u, 0u, 70000u, 17u}) {
+        offsets.push_back(offsets.back() + len);
+    }
+    std::vector<uint32_t> keys(offsets.back());
+    for (auto& k : keys) k = values(rng) % 4096u;
+
+    checkSegmentedSort(contextPtr, keys, offsets, 3);
+
+    REQUIRE_THROWS_AS(
+        mynydd::SegmentedSortPipeline(
+            contextPtr, std::make_shared<mynydd::Buffer>(contextPtr, 64, false), std::vector<uint32_t>{0, 10, 5}
+        ),
+        std::runtime_error
+    );
+}
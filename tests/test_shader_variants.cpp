@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/shader_variants.hpp>
+
+// Set by CMake; tests otherwise run from a build directory next to tests/
+#ifndef MYNYDD_TEST_SHADER_DIR
+#define MYNYDD_TEST_SHADER_DIR "../tests/shaders"
+#endif
+
+namespace fs = std::filesystem;
+
+static void writeFile(const fs::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+TEST_CASE("Shader variant keys depend on source, includes and defines", "[variants]") {
+    fs::path dir = fs::temp_directory_path() / "mynydd_variant_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "inc");
+
+    std::string source = dir / "kernel.comp";
+    writeFile(source, "#version 450\n#include \"common.kern\"\nvoid main() {}\n");
+    writeFile(dir / "inc" / "common.kern", "#define KEY_T uint\n");
+    std::vector<std::string> includeDirs{(dir / "inc").string()};
+
+    mynydd::ShaderDefines a{{"KEY_WORDS", "1"}, {"PAYLOAD_WORDS", "1"}};
+    mynydd::ShaderDefines aReordered{{"PAYLOAD_WORDS", "1"}, {"KEY_WORDS", "1"}};
+    mynydd::ShaderDefines b{{"KEY_WORDS", "2"}, {"PAYLOAD_WORDS", "1"}};
+
+    std::string keyA = mynydd::shaderVariantKey(source, a, includeDirs);
+    REQUIRE(keyA.size() == 16);
+    REQUIRE(keyA == mynydd::shaderVariantKey(source, aReordered, includeDirs));
+    REQUIRE(keyA != mynydd::shaderVariantKey(source, b, includeDirs));
+
+    // Editing an included file must produce a new variant
+    writeFile(dir / "inc" / "common.kern", "#define KEY_T uint64_t\n");
+    REQUIRE(keyA != mynydd::shaderVariantKey(source, a, includeDirs));
+
+    // A cached variant is served from disk without invoking the compiler
+    fs::path cacheDir = dir / "cache";
+    fs::create_directories(cacheDir);
+    std::vector<uint32_t> fakeSpirv{0x07230203u, 0x00010000u, 0u, 1u, 0u};
+    std::string cachePath = mynydd::shaderVariantCachePath(source, b, cacheDir.string(), includeDirs);
+    {
+        std::ofstream file(cachePath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(fakeSpirv.data()), fakeSpirv.size() * sizeof(uint32_t));
+    }
+    REQUIRE(mynydd::compileShaderVariant(source, b, cacheDir.string(), includeDirs) == fakeSpirv);
+
+    if (!mynydd::shaderCompilerAvailable()) {
+        REQUIRE_THROWS_AS(
+            mynydd::compileShaderVariant(source, a, cacheDir.string(), includeDirs),
+            std::runtime_error
+        );
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("A define-specialised shader variant is compiled and dispatched", "[variants]") {
+    const std::string source = std::string(MYNYDD_TEST_SHADER_DIR) + "/variant_scale.comp";
+    const mynydd::ShaderDefines defines{{"SCALE", "3u"}};
+    fs::path cacheDir = fs::temp_directory_path() / "mynydd_variant_dispatch_test";
+    fs::remove_all(cacheDir);
+
+    std::vector<uint32_t> spirv;
+    if (mynydd::shaderCompilerAvailable()) {
+        // A fresh cache, so this goes through shaderc and stores the result
+        spirv = mynydd::compileShaderVariant(source, defines, cacheDir.string());
+        REQUIRE(fs::exists(mynydd::shaderVariantCachePath(source, defines, cacheDir.string())));
+        REQUIRE(mynydd::compileShaderVariant(source, defines, cacheDir.string()) == spirv);
+    } else {
+        // Seed the cache with the same variant compiled at build time
+        fs::create_directories(cacheDir);
+        fs::copy_file(
+            "shaders/variant_scale.SCALE_3.comp.spv",
+            mynydd::shaderVariantCachePath(source, defines, cacheDir.string())
+        );
+        spirv = mynydd::compileShaderVariant(source, defines, cacheDir.string());
+    }
+
+    const uint32_t n = 1000;
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    auto data = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    std::vector<uint32_t> values(n);
+    for (uint32_t i = 0; i < n; ++i) values[i] = i;
+    mynydd::uploadData<uint32_t>(contextPtr, values, data);
+
+    auto step = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, spirv, "variant_scale.comp[SCALE=3u]",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{data},
+        (n + 255) / 256, 1, 1, std::vector<uint32_t>{sizeof(uint32_t)}
+    );
+    step->setPushConstantsData(n);
+    mynydd::executeBatch(contextPtr, {step});
+
+    auto out = mynydd::fetchData<uint32_t>(contextPtr, data, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        REQUIRE(out[i] == 3 * i);
+    }
+
+    fs::remove_all(cacheDir);
+}
@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/spirv_reflect.hpp>
+
+TEST_CASE("SPIR-V reflection reads bindings, access modes and workgroup size", "[reflect]") {
+    auto histogram = mynydd::reflectSpirv(mynydd::readShaderFile("shaders/histogram.comp.spv"));
+    REQUIRE(histogram.localSize == std::array<uint32_t, 3>{256, 1, 1});
+    REQUIRE(histogram.pushConstantSize == 0);
+    REQUIRE(histogram.bindings.size() == 3);
+    REQUIRE(histogram.bindings[0].binding == 0);
+    REQUIRE(histogram.bindings[0].type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    REQUIRE(histogram.bindings[0].readOnly);
+    REQUIRE(!histogram.bindings[1].readOnly);
+    REQUIRE(histogram.bindings[2].type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    REQUIRE(histogram.writesMemory());
+
+    auto transpose = mynydd::reflectSpirv(mynydd::readShaderFile("shaders/transpose.comp.spv"));
+    REQUIRE(transpose.bindings[1].writeOnly);
+
+    auto morton = mynydd::reflectSpirv(mynydd::readShaderFile("shaders/morton_u32_3d.comp.spv"));
+    REQUIRE(morton.localSize[0] == 64);
+
+    auto pushConstants = mynydd::reflectSpirv(mynydd::readShaderFile("shaders/push_constants.comp.spv"));
+    REQUIRE(pushConstants.pushConstantSize == sizeof(uint32_t));
+
+    auto bindless = mynydd::reflectSpirv(mynydd::readShaderFile("shaders/bindless.comp.spv"));
+    REQUIRE(bindless.bindings.empty());
+    REQUIRE(bindless.usesBufferDeviceAddress);
+    REQUIRE(bindless.pushConstantSize == 2 * sizeof(uint64_t) + sizeof(uint32_t));
+}
+
+TEST_CASE("Pipeline steps are validated against the shader interface", "[reflect]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    auto storage = std::make_shared<mynydd::Buffer>(contextPtr, 1024 * sizeof(uint32_t), false);
+    auto uniform = std::make_shared<mynydd::Buffer>(contextPtr, 64, true);
+
+    // Too few buffers
+    REQUIRE_THROWS_AS(
+        mynydd::PipelineStep(
+            contextPtr, "shaders/histogram.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{storage, storage}, 1
+        ),
+        std::runtime_error
+    );
+    // Storage buffer where a uniform block is declared
+    REQUIRE_THROWS_AS(
+        mynydd::PipelineStep(
+            contextPtr, "shaders/histogram.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{storage, storage, storage}, 1
+        ),
+        std::runtime_error
+    );
+    // Push constants not declared
+    REQUIRE_THROWS_AS(
+        mynydd::PipelineStep(
+            contextPtr, "shaders/push_constants.comp.spv",
+            std::vector<std::shared_ptr<mynydd::Buffer>>{storage}, 1
+        ),
+        std::runtime_error
+    );
+
+    auto step = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/morton_u32_3d.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{storage, storage, uniform}, 1
+    );
+    step->dispatchForElements(1000);
+    REQUIRE(step->groupCountX == 16);
+    step->dispatchForElements(1024);
+    REQUIRE(step->groupCountX == 16);
+    step->dispatchForElements(1025);
+    REQUIRE(step->groupCountX == 17);
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <mynydd/mynydd.hpp>
+#include <mynydd/tracer.hpp>
+
+TEST_CASE("Tracer records host scopes and GPU step ranges on one timeline", "[trace]") {
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    REQUIRE(contextPtr->tracer == nullptr);
+    auto tracer = mynydd::enableTracing(contextPtr);
+    REQUIRE(contextPtr->tracer == tracer);
+
+    uint32_t n = 512;
+    auto a = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto b = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    auto c = std::make_shared<mynydd::Buffer>(contextPtr, n * sizeof(uint32_t), false);
+    mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(n, 2), a);
+    mynydd::uploadData<uint32_t>(contextPtr, std::vector<uint32_t>(n, 3), b);
+
+    auto add = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/graph_add.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{a, b, c},
+        n / 256
+    );
+    auto addAgain = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/graph_add.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{a, c, b},
+        n / 256
+    );
+    REQUIRE(add->getName() == "shaders/graph_add.comp.spv");
+    addAgain->setName("add again");
+
+    mynydd::executeBatch(contextPtr, {add, addAgain});
+    std::vector<uint32_t> out = mynydd::fetchData<uint32_t>(contextPtr, b, n);
+    REQUIRE(out[0] == 7);
+
+    auto events = tracer->getEvents();
+    auto find = [&](const std::string& name) {
+        return std::find_if(events.begin(), events.end(), [&](const mynydd::Tracer::Event& e) {
+            return e.name == name;
+        });
+    };
+    for (const char* name : {"upload", "record", "submit", "wait", "fetch"}) {
+        auto it = find(name);
+        REQUIRE(it != events.end());
+        REQUIRE(it->category == "host");
+        REQUIRE(it->endNs >= it->beginNs);
+    }
+
+    if (tracer->gpuTimingSupported()) {
+        auto first = find("shaders/graph_add.comp.spv");
+        auto second = find("add again");
+        REQUIRE(first != events.end());
+        REQUIRE(second != events.end());
+        REQUIRE(first->category == "gpu");
+        REQUIRE(first->track == 0);
+        REQUIRE(second->beginNs >= first->beginNs);
+
+        // GPU work falls between the submit starting and the wait returning, give or
+        // take the calibration error
+        int64_t slackNs = 5'000'000;
+        REQUIRE(first->beginNs + slackNs >= find("submit")->beginNs);
+        REQUIRE(second->endNs <= find("wait")->endNs + slackNs);
+    } else {
+        WARN("Queue has no timestamp support; only host events were traced");
+    }
+
+    const std::string tracePath = (std::filesystem::temp_directory_path() / "mynydd_trace_test.json").string();
+    tracer->writeChromeTrace(tracePath);
+    std::string json;
+    {
+        std::ifstream file(tracePath);
+        json.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::filesystem::remove(tracePath);
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"wait\"") != std::string::npos);
+
+    tracer->clear();
+    REQUIRE(tracer->getEvents().empty());
+}
@@ -158,4 +158,41 @@ TEST_CASE("Transpose + per-row prefix compute correct per-workgroup prefix sums"
     for (size_t i = 0; i < cpuPrefix.size(); ++i) {
         REQUIRE(gpuPrefix[i] == cpuPrefix[i]);
     }
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("Workgroup scan handles rows longer than 256 tiles", "[vulkan]") {
+    // 70000 bins is above the 256 * 256 row length the per-tile totals used to allow
+    const uint32_t rows = 2;
+    const uint32_t numBins = 70000;
+
+    auto contextPtr = std::make_shared<mynydd::VulkanContext>();
+    auto histBuffer = std::make_shared<mynydd::Buffer>(contextPtr, rows * numBins * sizeof(uint32_t), false);
+    auto prefixBuffer = std::make_shared<mynydd::Buffer>(contextPtr, rows * numBins * sizeof(uint32_t), false);
+
+    struct PrefixParams { uint32_t histogramCount; uint32_t numBins; };
+    auto pUniform = std::make_shared<mynydd::Buffer>(contextPtr, sizeof(PrefixParams), true);
+
+    std::vector<uint32_t> hist(rows * numBins);
+    std::vector<uint32_t> cpuPrefix(rows * numBins);
+    for (uint32_t r = 0; r < rows; ++r) {
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < numBins; ++b) {
+            hist[r * numBins + b] = (b * 7 + r) % 5;
+            cpuPrefix[r * numBins + b] = sum;
+            sum += hist[r * numBins + b];
+        }
+    }
+    mynydd::uploadData<uint32_t>(contextPtr, hist, histBuffer);
+    mynydd::uploadUniformData<PrefixParams>(contextPtr, PrefixParams{rows, numBins}, pUniform);
+
+    auto prefixPipeline = std::make_shared<mynydd::PipelineStep>(
+        contextPtr, "shaders/workgroup_scan.comp.spv",
+        std::vector<std::shared_ptr<mynydd::Buffer>>{histBuffer, prefixBuffer, pUniform},
+        rows
+    );
+    mynydd::executeBatch(contextPtr, {prefixPipeline});
+
+    std::vector<uint32_t> gpuPrefix = mynydd::fetchData<uint32_t>(contextPtr, prefixBuffer, rows * numBins);
+    REQUIRE(gpuPrefix == cpuPrefix);
+}
@@ -0,0 +1,346 @@
+// mynydd_devbench: measures per-device characteristics used to tune workgroup sizes
+// and radix widths, and writes them as a JSON device profile.
+//
+//   mynydd_devbench [--quick] [--runs N] [--output profile.json] [--shaders DIR]
+//
+// --quick uses small problem sizes so the suite finishes quickly on software
+// rasterisers such as lavapipe; the numbers are then only a sanity check.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <mynydd/embedded_shaders.hpp>
+#include <mynydd/mynydd.hpp>
+#include <mynydd/tracer.hpp>
+
+#ifndef DEVBENCH_SHADER_DIR
+#define DEVBENCH_SHADER_DIR "tools/devbench"
+#endif
+
+namespace {
+
+    struct BenchParams {
+        uint32_t nElements;
+        uint32_t iterations;
+        uint32_t gridBits;
+        uint32_t pad;
+    };
+
+    struct Options {
+        bool quick = false;
+        int runs = 5;
+        std::string output;
+        std::string shaderDir = DEVBENCH_SHADER_DIR;
+    };
+
+    struct Result {
+        std::string name;
+        double value;
+        std::string unit;
+        double seconds; // fastest measured run
+    };
+
+    class DeviceBench {
+        public:
+            DeviceBench(std::shared_ptr<mynydd::VulkanContext> contextPtr, const Options& options)
+                : contextPtr(contextPtr), options(options) {
+                tracer = mynydd::enableTracing(contextPtr, 256);
+            }
+
+            std::shared_ptr<mynydd::PipelineStep> makeStep(
+                const std::string& shader,
+                std::vector<std::shared_ptr<mynydd::Buffer>> buffers,
+                uint32_t groupCount,
+                const BenchParams& params
+            ) {
+                std::string path = options.shaderDir + "/" + shader + ".spv";
+                auto step = std::make_shared<mynydd::PipelineStep>(
+                    contextPtr, path.c_str(), std::move(buffers), groupCount, 1, 1,
+                    std::vector<uint32_t>{sizeof(BenchParams)}
+                );
+                step->setName(shader);
+                step->setPushConstantsData(params);
+                return step;
+            }
+
+            // The copy and FMA kernels are the library's roofline probes, so the profile
+            // and measureDevicePeaks time the same code. Their push constants are a prefix
+            // of BenchParams.
+            std::shared_ptr<mynydd::PipelineStep> makeProbeStep(
+                const std::string& shader,
+                std::vector<std::shared_ptr<mynydd::Buffer>> buffers,
+                uint32_t groupCount,
+                const BenchParams& params
+            ) {
+                auto step = std::make_shared<mynydd::PipelineStep>(
+                    contextPtr, mynydd::getEmbeddedShader(shader), shader, std::move(buffers), groupCount, 1, 1,
+                    std::vector<uint32_t>{sizeof(BenchParams)}
+                );
+                step->setPushConstantsData(params);
+                return step;
+            }
+
+            // Fastest of the timed runs after one warm-up, from GPU timestamps where
+            // available; the host time of the whole batch otherwise
+            double time(const std::vector<std::shared_ptr<mynydd::PipelineStep>>& steps) {
+                double best = std::numeric_limits<double>::max();
+                for (int run = 0; run <= options.runs; ++run) {
+                    tracer->clear();
+                    int64_t begin = mynydd::Tracer::nowNs();
+                    mynydd::executeBatch(contextPtr, steps);
+                    int64_t end = mynydd::Tracer::nowNs();
+
+                    double seconds = static_cast<double>(end - begin) * 1e-9;
+                    if (tracer->gpuTimingSupported()) {
+                        int64_t first = std::numeric_limits<int64_t>::max();
+                        int64_t last = std::numeric_limits<int64_t>::min();
+                        for (const auto& event : tracer->getEvents()) {
+                            if (event.category == "gpu") {
+                                first = std::min(first, event.beginNs);
+                                last = std::max(last, event.endNs);
+                            }
+                        }
+                        if (last > first) {
+                            seconds = static_cast<double>(last - first) * 1e-9;
+                        }
+                    }
+                    if (run > 0) {
+                        best = std::min(best, seconds);
+                    }
+                }
+                return best;
+            }
+
+            // Host round trip of executeBatch, averaged; includes record, submit and wait
+            // Tracing is switched off meanwhile so its query resets are not counted
+            double hostLatency(const std::vector<std::shared_ptr<mynydd::PipelineStep>>& steps, int repeats) {
+                contextPtr->tracer.reset();
+                mynydd::executeBatch(contextPtr, steps);
+                int64_t begin = mynydd::Tracer::nowNs();
+                for (int i = 0; i < repeats; ++i) {
+                    mynydd::executeBatch(contextPtr, steps);
+                }
+                double seconds = static_cast<double>(mynydd::Tracer::nowNs() - begin) * 1e-9 / repeats;
+                contextPtr->tracer = tracer;
+                return seconds;
+            }
+
+            std::shared_ptr<mynydd::Buffer> buffer(uint64_t bytes) {
+                return std::make_shared<mynydd::Buffer>(contextPtr, bytes, false);
+            }
+
+            void add(const std::string& name, double value, const std::string& unit, double seconds) {
+                results.push_back({name, value, unit, seconds});
+                std::cerr << name << ": " << value << " " << unit << std::endl;
+            }
+
+            void run() {
+                runBandwidth();
+                runAtomics();
+                runBarrier();
+                runFlops();
+                runLatency();
+            }
+
+            std::shared_ptr<mynydd::VulkanContext> contextPtr;
+            std::shared_ptr<mynydd::Tracer> tracer;
+            Options options;
+            std::vector<Result> results;
+
+        private:
+            void runBandwidth() {
+                // A cube of 2^gridBits cells per axis, one vec4 per cell
+                uint32_t gridBits = options.quick ? 6 : 7;
+                uint32_t n = 1u << (3 * gridBits);
+                uint64_t bytes = static_cast<uint64_t>(n) * 16;
+                auto src = buffer(bytes);
+                auto dst = buffer(bytes);
+                BenchParams params{n, 0, gridBits, 0};
+                uint32_t groups = n / 256;
+
+                double t = time({makeStep("bench_read.comp", {src, dst}, groups, params)});
+                add("read_coalesced", bytes / t * 1e-9, "GB/s", t);
+                t = time({makeStep("bench_write.comp", {dst}, groups, params)});
+                add("write_coalesced", bytes / t * 1e-9, "GB/s", t);
+                t = time({makeProbeStep("probe_bandwidth.comp", {src, dst}, groups, params)});
+                add("copy_coalesced", 2 * bytes / t * 1e-9, "GB/s", t);
+                t = time({makeStep("bench_gather_morton.comp", {src, dst}, groups, params)});
+                add("copy_morton_gather", 2 * bytes / t * 1e-9, "GB/s", t);
+            }
+
+            void runAtomics() {
+                uint32_t groups = options.quick ? 64 : 1024;
+                uint32_t iterations = options.quick ? 64 : 256;
+                double atomics = static_cast<double>(groups) * 256 * iterations;
+
+                auto histogram = buffer(static_cast<uint64_t>(groups) * 256 * sizeof(uint32_t));
+                double t = time({makeStep("bench_shared_atomics.comp", {histogram}, groups, {0, iterations, 0, 0})});
+                add("shared_atomics", atomics / t * 1e-9, "Gatomic/s", t);
+
+                uint32_t nCounters = 4096;
+                auto counters = buffer(nCounters * sizeof(uint32_t));
+                t = time({makeStep("bench_global_atomics.comp", {counters}, groups, {nCounters, iterations, 0, 0})});
+                add("global_atomics", atomics / t * 1e-9, "Gatomic/s", t);
+            }
+
+            void runBarrier() {
+                // One workgroup, so the time is the latency of the barrier chain itself
+                uint32_t iterations = options.quick ? 1024 : 16384;
+                auto result = buffer(256 * sizeof(uint32_t));
+                double t = time({makeStep("bench_barrier.comp", {result}, 1, {0, iterations, 0, 0})});
+                add("barrier_latency", t * 1e9 / (2.0 * iterations), "ns", t);
+            }
+
+            void runFlops() {
+                uint32_t groups = options.quick ? 64 : 1024;
+                uint32_t iterations = options.quick ? 64 : 512;
+                double flops = static_cast<double>(groups) * 256 * iterations * 32;
+
+                auto f32 = buffer(static_cast<uint64_t>(groups) * 256 * sizeof(float));
+                double t = time({makeProbeStep("probe_flops.comp", {f32}, groups, {0, iterations, 0, 0})});
+                add("fma_f32", flops / t * 1e-9, "GFLOP/s", t);
+
+                VkPhysicalDeviceFeatures features;
+                vkGetPhysicalDeviceFeatures(contextPtr->physicalDevice, &features);
+                if (features.shaderFloat64) {
+                    auto f64 = buffer(static_cast<uint64_t>(groups) * 256 * sizeof(double));
+                    t = time({makeStep("bench_fma_f64.comp", {f64}, groups, {0, iterations, 0, 0})});
+                    add("fma_f64", flops / t * 1e-9, "GFLOP/s", t);
+                }
+            }
+
+            void runLatency() {
+                int repeats = options.quick ? 20 : 200;
+                uint32_t batch = 64;
+                auto result = buffer(sizeof(uint32_t));
+                auto empty = makeStep("bench_empty.comp", {result}, 1, {0, 0, 0, 0});
+
+                double single = hostLatency({empty}, repeats);
+                add("submit_wait_latency", single * 1e6, "us", single);
+
+                std::vector<std::shared_ptr<mynydd::PipelineStep>> many(batch, empty);
+                double batched = hostLatency(many, repeats);
+                double perDispatch = std::max(0.0, (batched - single) / (batch - 1));
+                add("dispatch_overhead", perDispatch * 1e6, "us", batched);
+
+                double t = time({empty});
+                add("empty_dispatch_gpu", t * 1e6, "us", t);
+            }
+    };
+
+    std::string jsonString(const std::string& text) {
+        std::string out = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+            }
+            out.push_back(c);
+        }
+        return out + "\"";
+    }
+
+    const char* deviceTypeName(VkPhysicalDeviceType type) {
+        switch (type) {
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated_gpu";
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete_gpu";
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+            default: return "other";
+        }
+    }
+
+    std::string profileJson(const DeviceBench& bench) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(bench.contextPtr->physicalDevice, &props);
+
+        std::ostringstream json;
+        json.precision(6);
+        json << "{\n  \"device\": {\n"
+             << "    \"name\": " << jsonString(props.deviceName) << ",\n"
+             << "    \"type\": \"" << deviceTypeName(props.deviceType) << "\",\n"
+             << "    \"vendorID\": " << props.vendorID << ",\n"
+             << "    \"deviceID\": " << props.deviceID << ",\n"
+             << "    \"driverVersion\": " << props.driverVersion << ",\n"
+             << "    \"apiVersion\": \"" << VK_VERSION_MAJOR(props.apiVersion) << "."
+                 << VK_VERSION_MINOR(props.apiVersion) << "." << VK_VERSION_PATCH(props.apiVersion) << "\",\n"
+             << "    \"maxComputeWorkGroupInvocations\": " << props.limits.maxComputeWorkGroupInvocations << ",\n"
+             << "    \"maxComputeSharedMemorySize\": " << props.limits.maxComputeSharedMemorySize << ",\n"
+             << "    \"maxStorageBufferRange\": " << props.limits.maxStorageBufferRange << ",\n"
+             << "    \"timestampPeriodNs\": " << props.limits.timestampPeriod << ",\n"
+             << "    \"gpuTiming\": " << (bench.tracer->gpuTimingSupported() ? "true" : "false") << "\n"
+             << "  },\n"
+             << "  \"quick\": " << (bench.options.quick ? "true" : "false") << ",\n"
+             << "  \"results\": [";
+        for (size_t i = 0; i < bench.results.size(); ++i) {
+            const Result& r = bench.results[i];
+            json << (i ? ",\n" : "\n")
+                 << "    {\"name\": " << jsonString(r.name)
+                 << ", \"value\": " << r.value
+                 << ", \"unit\": " << jsonString(r.unit)
+                 << ", \"seconds\": " << r.seconds << "}";
+        }
+        json << "\n  ]\n}\n";
+        return json.str();
+    }
+
+    Options parseArgs(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--quick") {
+                options.quick = true;
+            } else if (arg == "--runs") {
+                options.runs = std::max(1, std::stoi(value()));
+            } else if (arg == "--output") {
+                options.output = value();
+            } else if (arg == "--shaders") {
+                options.shaderDir = value();
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        return options;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parseArgs(argc, argv);
+        auto contextPtr = std::make_shared<mynydd::VulkanContext>(false);
+
+        DeviceBench bench(contextPtr, options);
+        bench.run();
+
+        std::string json = profileJson(bench);
+        if (options.output.empty()) {
+            std::cout << json;
+        } else {
+            std::ofstream file(options.output, std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open " + options.output + " for writing");
+            }
+            file << json;
+            std::cerr << "Wrote device profile to " << options.output << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "mynydd_devbench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+// mynydd_replay: reruns a batch written by captureNextBatch and reports its timing.
+//
+//   mynydd_replay capture.bin [--iterations N] [--no-restore]
+//
+// Buffers are reset to their captured contents before every iteration unless
+// --no-restore is given, so in-place kernels such as a radix pass see the same input
+// each time. Per-step times come from GPU timestamps when the queue supports them.
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <mynydd/capture.hpp>
+#include <mynydd/mynydd.hpp>
+#include <mynydd/tracer.hpp>
+
+namespace {
+
+    struct Options {
+        std::string capturePath;
+        int iterations = 10;
+        bool restore = true;
+    };
+
+    Options parseArgs(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--iterations") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for --iterations");
+                }
+                options.iterations = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--no-restore") {
+                options.restore = false;
+            } else if (options.capturePath.empty()) {
+                options.capturePath = arg;
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        if (options.capturePath.empty()) {
+            throw std::runtime_error("usage: mynydd_replay capture.bin [--iterations N] [--no-restore]");
+        }
+        return options;
+    }
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        size_t mid = values.size() / 2;
+        return values.size() % 2 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+    }
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parseArgs(argc, argv);
+        mynydd::BatchCapture capture = mynydd::readCapture(options.capturePath);
+        if (capture.externalCommands) {
+            std::cerr << "Warning: the captured batch followed commands recorded by the application; "
+                         "those are not replayed" << std::endl;
+        }
+
+        auto contextPtr = std::make_shared<mynydd::VulkanContext>(false);
+        mynydd::ReplayBatch replay = mynydd::instantiateCapture(contextPtr, capture);
+        auto tracer = mynydd::enableTracing(contextPtr, static_cast<uint32_t>(replay.steps.size()));
+
+        uint64_t capturedBytes = 0;
+        for (const auto& buffer : capture.buffers) {
+            capturedBytes += buffer.size;
+        }
+        std::cerr << "Replaying " << replay.steps.size() << " steps over " << replay.buffers.size()
+                  << " buffers (" << capturedBytes << " bytes) from " << options.capturePath << std::endl;
+
+        // One warm-up run, then the timed iterations
+        std::vector<double> batchTimes;
+        std::vector<std::vector<double>> stepTimes(replay.steps.size());
+        for (int it = 0; it <= options.iterations; ++it) {
+            if (options.restore) {
+                mynydd::restoreCaptureBuffers(contextPtr, capture, replay);
+            }
+            tracer->clear();
+            int64_t begin = mynydd::Tracer::nowNs();
+            mynydd::executeBatch(contextPtr, replay.steps);
+            int64_t end = mynydd::Tracer::nowNs();
+            if (it == 0) {
+                continue;
+            }
+            batchTimes.push_back(static_cast<double>(end - begin) * 1e-6);
+
+            // Ranges come back in recording order, one per step
+            size_t s = 0;
+            for (const auto& event : tracer->getEvents()) {
+                if (event.category == "gpu" && s < stepTimes.size()) {
+                    stepTimes[s++].push_back(static_cast<double>(event.endNs - event.beginNs) * 1e-6);
+                }
+            }
+        }
+
+        std::cout << std::fixed << std::setprecision(4);
+        std::cout << "batch (host, submit to fence): min " << *std::min_element(batchTimes.begin(), batchTimes.end())
+                  << " ms, median " << median(batchTimes) << " ms over " << batchTimes.size() << " iterations"
+                  << std::endl;
+        for (size_t s = 0; s < replay.steps.size(); ++s) {
+            const auto& step = capture.steps[s];
+            std::cout << "  [" << s << "] " << step.name << " (" << step.groupCount[0] << "x"
+                      << step.groupCount[1] << "x" << step.groupCount[2] << ")";
+            if (stepTimes[s].empty()) {
+                std::cout << ": no GPU timing" << std::endl;
+            } else {
+                std::cout << ": min " << *std::min_element(stepTimes[s].begin(), stepTimes[s].end())
+                          << " ms, median " << median(stepTimes[s]) << " ms" << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "mynydd_replay: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}